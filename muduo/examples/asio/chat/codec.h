@@ -63,6 +63,18 @@ class LengthHeaderCodec : boost::noncopyable
     conn->send(&buf);
   }
 
+  // header and message go out with one writev(2), message is not copied
+  void send(muduo::net::TcpConnection* conn,
+            const muduo::net::PayloadPtr& message)
+  {
+    muduo::net::BufferChain frame;
+    frame.append(message, message->data(), message->size());
+    int32_t len = static_cast<int32_t>(message->size());
+    int32_t be32 = muduo::net::sockets::hostToNetwork32(len);
+    frame.prepend(&be32, sizeof be32);
+    conn->send(&frame);
+  }
+
  private:
   StringMessageCallback messageCallback_;
   const static size_t kHeaderLen = sizeof(int32_t);
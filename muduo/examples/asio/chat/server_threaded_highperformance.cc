@@ -62,7 +62,9 @@ class ChatServer : boost::noncopyable
                        const string& message,
                        Timestamp)
   {
-    EventLoop::Functor f = boost::bind(&ChatServer::distributeMessage, this, message);
+    // one copy shared by all loops and connections
+    PayloadPtr payload(new Payload(message));
+    EventLoop::Functor f = boost::bind(&ChatServer::distributeMessage, this, payload);
     LOG_DEBUG;
 
     MutexLockGuard lock(mutex_);
@@ -77,7 +79,7 @@ class ChatServer : boost::noncopyable
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
 
-  void distributeMessage(const string& message)
+  void distributeMessage(const PayloadPtr& message)
   {
     LOG_DEBUG << "begin";
     for (ConnectionList::iterator it = connections_.instance().begin();
@@ -0,0 +1,72 @@
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpClient.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// downloads the file over many connections at once, like Client.java,
+// prints throughput, to compare filetransfer_download{,2,3,4}
+
+int g_clients = 0;
+int g_done = 0;
+int64_t g_bytes = 0;
+Timestamp g_start;
+
+void onConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+{
+  if (!conn->connected())
+  {
+    if (++g_done == g_clients)
+    {
+      double seconds = timeDifference(Timestamp::now(), g_start);
+      printf("%d clients, %.1f MiB in %.3f seconds, %.1f MiB/s\n",
+             g_clients, static_cast<double>(g_bytes) / (1024*1024), seconds,
+             static_cast<double>(g_bytes) / (1024*1024) / seconds);
+      loop->quit();
+    }
+  }
+}
+
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  g_bytes += buf->readableBytes();
+  buf->retrieveAll();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s <host_ip> <clients> [port]\n", argv[0]);
+  }
+  else
+  {
+    Logger::setLogLevel(Logger::WARN);
+    const char* ip = argv[1];
+    g_clients = atoi(argv[2]);
+    uint16_t port = static_cast<uint16_t>(argc > 3 ? atoi(argv[3]) : 2021);
+
+    EventLoop loop;
+    InetAddress serverAddr(ip, port);
+    boost::ptr_vector<TcpClient> clients;
+    g_start = Timestamp::now();
+    for (int i = 0; i < g_clients; ++i)
+    {
+      char buf[32];
+      snprintf(buf, sizeof buf, "FileClient%d", i);
+      TcpClient* client = new TcpClient(&loop, serverAddr, buf);
+      clients.push_back(client);
+      client->setConnectionCallback(boost::bind(onConnection, &loop, _1));
+      client->setMessageCallback(onMessage);
+      client->connect();
+    }
+    loop.loop();
+  }
+}
@@ -0,0 +1,259 @@
+// Broadcasts messages from one topic to many slow subscribers,
+// compares per-connection copies with a shared Payload.
+//
+// Usage: hub_fanout_bench [copy|shared] [subscribers] [messages] [size]
+//
+// Subscribers live in a forked child, so both sides fit in RLIMIT_NOFILE.
+// They don't read until every message is published, so the memory
+// growth of the publisher is what queues up in output buffers.
+
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpServer.h>
+
+#include <boost/bind.hpp>
+
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 9011;
+
+bool g_shared = true;
+int g_subscribers = 10000;
+int g_messages = 8;
+int g_size = 16384;
+
+double residentMiB()
+{
+  long pages = 0;
+  long resident = 0;
+  FILE* fp = ::fopen("/proc/self/statm", "r");
+  if (fp)
+  {
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+    {
+      resident = 0;
+    }
+    ::fclose(fp);
+  }
+  return static_cast<double>(resident) * static_cast<double>(::sysconf(_SC_PAGESIZE)) / (1024*1024);
+}
+
+void subscribers(int readyFd, int doneFd)
+{
+  char byte = 0;
+  if (::read(readyFd, &byte, 1) != 1)
+    _exit(1);
+
+  struct sockaddr_in addr;
+  bzero(&addr, sizeof addr);
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(kPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  int epollfd = ::epoll_create1(EPOLL_CLOEXEC);
+  std::vector<int> fds;
+  for (int i = 0; i < g_subscribers; ++i)
+  {
+    int fd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int rcvbuf = 4096;  // slow subscriber, keep data in the publisher
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) < 0)
+    {
+      perror("connect");
+      _exit(1);
+    }
+    ::fcntl(fd, F_SETFL, O_NONBLOCK);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = static_cast<uint32_t>(fds.size());
+    ::epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &ev);
+    fds.push_back(fd);
+  }
+
+  // wait for publishing
+  if (::read(readyFd, &byte, 1) != 1)
+    _exit(1);
+
+  const int64_t expected = static_cast<int64_t>(g_messages) * g_size;
+  std::vector<int64_t> received(fds.size());
+  size_t finished = 0;
+  std::vector<struct epoll_event> events(1024);
+  char buf[65536];
+  while (finished < fds.size())
+  {
+    int n = ::epoll_wait(epollfd, &events[0], static_cast<int>(events.size()), 10000);
+    if (n <= 0)
+      break;
+    for (int i = 0; i < n; ++i)
+    {
+      uint32_t idx = events[i].data.u32;
+      ssize_t nr = 0;
+      while ((nr = ::read(fds[idx], buf, sizeof buf)) > 0)
+      {
+        received[idx] += nr;
+      }
+      if (received[idx] >= expected)
+      {
+        ::epoll_ctl(epollfd, EPOLL_CTL_DEL, fds[idx], NULL);
+        ++finished;
+      }
+    }
+  }
+  if (::write(doneFd, &byte, 1) != 1)
+    _exit(1);
+  for (size_t i = 0; i < fds.size(); ++i)
+  {
+    ::close(fds[i]);
+  }
+  _exit(finished == fds.size() ? 0 : 1);
+}
+
+class Publisher : boost::noncopyable
+{
+ public:
+  Publisher(EventLoop* loop, int readyFd, int doneFd)
+    : loop_(loop),
+      server_(loop, InetAddress(kPort), "FanoutBench"),
+      readyFd_(readyFd),
+      doneFd_(doneFd),
+      connected_(1),
+      published_(1),
+      thread_(boost::bind(&Publisher::run, this), "bench")
+  {
+    server_.setConnectionCallback(
+        boost::bind(&Publisher::onConnection, this, _1));
+  }
+
+  void start()
+  {
+    server_.start();
+    thread_.start();
+  }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      audiences_.push_back(conn);
+      if (audiences_.size() == static_cast<size_t>(g_subscribers))
+      {
+        connected_.countDown();
+      }
+    }
+  }
+
+  void publish()
+  {
+    string content(g_size, 'x');
+    for (int i = 0; i < g_messages; ++i)
+    {
+      if (g_shared)
+      {
+        PayloadPtr message(new Payload(content));
+        for (size_t j = 0; j < audiences_.size(); ++j)
+        {
+          audiences_[j]->send(message);
+        }
+      }
+      else
+      {
+        for (size_t j = 0; j < audiences_.size(); ++j)
+        {
+          audiences_[j]->send(content);
+        }
+      }
+    }
+    published_.countDown();
+  }
+
+  void run()
+  {
+    char byte = 0;
+    if (::write(readyFd_, &byte, 1) != 1)
+      return;
+    connected_.wait();
+
+    double before = residentMiB();
+    Timestamp start(Timestamp::now());
+    loop_->runInLoop(boost::bind(&Publisher::publish, this));
+    published_.wait();
+    Timestamp published(Timestamp::now());
+    double after = residentMiB();
+
+    if (::write(readyFd_, &byte, 1) != 1 || ::read(doneFd_, &byte, 1) != 1)
+    {
+      fprintf(stderr, "subscribers failed\n");
+    }
+    Timestamp delivered(Timestamp::now());
+
+    double totalMiB = static_cast<double>(g_messages) * g_size * g_subscribers / (1024*1024);
+    printf("%s: %d subscribers, %d messages of %d bytes\n",
+           g_shared ? "shared" : "copy", g_subscribers, g_messages, g_size);
+    printf("  publish   %.3f seconds, %.0f messages/s\n",
+           timeDifference(published, start),
+           g_messages * g_subscribers / timeDifference(published, start));
+    printf("  memory    %.1f MiB more resident after publishing\n", after - before);
+    printf("  deliver   %.3f seconds, %.1f MiB/s\n",
+           timeDifference(delivered, start),
+           totalMiB / timeDifference(delivered, start));
+    loop_->quit();
+  }
+
+  EventLoop* loop_;
+  TcpServer server_;
+  int readyFd_;
+  int doneFd_;
+  CountDownLatch connected_;
+  CountDownLatch published_;
+  Thread thread_;
+  std::vector<TcpConnectionPtr> audiences_;
+};
+
+int main(int argc, char* argv[])
+{
+  g_shared = !(argc > 1 && strcmp(argv[1], "copy") == 0);
+  if (argc > 2) g_subscribers = atoi(argv[2]);
+  if (argc > 3) g_messages = atoi(argv[3]);
+  if (argc > 4) g_size = atoi(argv[4]);
+
+  int toChild[2];
+  int toParent[2];
+  if (::pipe(toChild) < 0 || ::pipe(toParent) < 0)
+  {
+    perror("pipe");
+    return 1;
+  }
+
+  pid_t child = ::fork();
+  if (child == 0)
+  {
+    subscribers(toChild[0], toParent[1]);
+  }
+
+  Logger::setLogLevel(Logger::WARN);
+  {
+    EventLoop loop;
+    Publisher publisher(&loop, toChild[1], toParent[0]);
+    publisher.start();
+    loop.loop();
+  }
+  int status = 0;
+  ::waitpid(child, &status, 0);
+}
@@ -31,7 +31,7 @@ class Topic : public muduo::copyable
     audiences_.insert(conn);
     if (lastPubTime_.valid())
     {
-      conn->send(makeMessage());
+      conn->send(message_);
     }
   }
 
@@ -44,12 +44,13 @@ class Topic : public muduo::copyable
   {
     content_ = content;
     lastPubTime_ = time;
-    string message = makeMessage();
+    // one copy shared by all audiences
+    message_.reset(new Payload(makeMessage()));
     for (std::set<TcpConnectionPtr>::iterator it = audiences_.begin();
          it != audiences_.end();
          ++it)
     {
-      (*it)->send(message);
+      (*it)->send(message_);
     }
   }
 
@@ -63,6 +64,7 @@ class Topic : public muduo::copyable
   string topic_;
   string content_;
   Timestamp lastPubTime_;
+  PayloadPtr message_;
   std::set<TcpConnectionPtr> audiences_;
 };
 
@@ -13,6 +13,7 @@
 
 #include <mcheck.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -26,7 +27,8 @@ class Session : boost::noncopyable
   Session(EventLoop* loop,
           const InetAddress& serverAddr,
           const string& name,
-          Client* owner)
+          Client* owner,
+          bool edgeTriggered)
     : client_(loop, serverAddr, name),
       owner_(owner),
       bytesRead_(0),
@@ -37,6 +39,7 @@ class Session : boost::noncopyable
         boost::bind(&Session::onConnection, this, _1));
     client_.setMessageCallback(
         boost::bind(&Session::onMessage, this, _1, _2, _3));
+    client_.setEdgeTriggered(edgeTriggered);
   }
 
   void start()
@@ -86,7 +89,8 @@ class Client : boost::noncopyable
          int blockSize,
          int sessionCount,
          int timeout,
-         int threadCount)
+         int threadCount,
+         bool edgeTriggered)
     : loop_(loop),
       threadPool_(loop),
       sessionCount_(sessionCount),
@@ -98,6 +102,7 @@ class Client : boost::noncopyable
       threadPool_.setThreadNum(threadCount);
     }
     threadPool_.start();
+    loops_ = threadPool_.getAllLoops();
 
     for (int i = 0; i < blockSize; ++i)
     {
@@ -108,7 +113,8 @@ class Client : boost::noncopyable
     {
       char buf[32];
       snprintf(buf, sizeof buf, "C%05d", i);
-      Session* session = new Session(threadPool_.getNextLoop(), serverAddr, buf, this);
+      Session* session = new Session(threadPool_.getNextLoop(), serverAddr, buf, this,
+                                     edgeTriggered);
       session->start();
       sessions_.push_back(session);
     }
@@ -147,6 +153,23 @@ class Client : boost::noncopyable
                << " average message size";
       LOG_WARN << static_cast<double>(totalBytesRead) / (timeout_ * 1024 * 1024)
                << " MiB/s throughput";
+
+      // loops are idle now
+      int64_t polls = 0;
+      EventLoop::SyscallStats stats = { 0, 0, 0, 0 };
+      for (size_t i = 0; i < loops_.size(); ++i)
+      {
+        polls += loops_[i]->iteration();
+        stats.pollerUpdates += loops_[i]->syscallStats().pollerUpdates;
+        stats.reads += loops_[i]->syscallStats().reads;
+        stats.writes += loops_[i]->syscallStats().writes;
+      }
+      double messages = static_cast<double>(totalMessagesRead);
+      LOG_WARN << "syscalls per message: "
+               << static_cast<double>(polls) / messages << " poll, "
+               << static_cast<double>(stats.pollerUpdates) / messages << " epoll_ctl, "
+               << static_cast<double>(stats.reads) / messages << " read, "
+               << static_cast<double>(stats.writes) / messages << " write";
       loop_->queueInLoop(boost::bind(&EventLoop::quit, loop_));
     }
   }
@@ -162,6 +185,7 @@ class Client : boost::noncopyable
 
   EventLoop* loop_;
   EventLoopThreadPool threadPool_;
+  std::vector<EventLoop*> loops_;
   int sessionCount_;
   int timeout_;
   boost::ptr_vector<Session> sessions_;
@@ -185,10 +209,10 @@ void Session::onConnection(const TcpConnectionPtr& conn)
 
 int main(int argc, char* argv[])
 {
-  if (argc != 7)
+  if (argc != 7 && argc != 8)
   {
     fprintf(stderr, "Usage: client <host_ip> <port> <threads> <blocksize> ");
-    fprintf(stderr, "<sessions> <time>\n");
+    fprintf(stderr, "<sessions> <time> [et]\n");
   }
   else
   {
@@ -201,11 +225,13 @@ int main(int argc, char* argv[])
     int blockSize = atoi(argv[4]);
     int sessionCount = atoi(argv[5]);
     int timeout = atoi(argv[6]);
+    bool edgeTriggered = argc > 7 && strcmp(argv[7], "et") == 0;
 
     EventLoop loop;
     InetAddress serverAddr(ip, port);
 
-    Client client(&loop, serverAddr, blockSize, sessionCount, timeout, threadCount);
+    Client client(&loop, serverAddr, blockSize, sessionCount, timeout, threadCount,
+                  edgeTriggered);
     loop.loop();
   }
 }
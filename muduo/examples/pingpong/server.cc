@@ -10,19 +10,33 @@
 
 #include <utility>
 
+#include <inttypes.h>
 #include <mcheck.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+AtomicInt64 g_closedConnections;
+
 void onConnection(const TcpConnectionPtr& conn)
 {
   if (conn->connected())
   {
     conn->setTcpNoDelay(true);
   }
+  else
+  {
+    g_closedConnections.increment();
+    const ConnectionStats& stats = conn->stats();
+    LOG_INFO << conn->name() << " lived "
+             << timeDifference(Timestamp::now(), conn->creationTime()) << "s, "
+             << stats.bytesReceived << " bytes in, "
+             << stats.bytesSent << " bytes out, "
+             << stats.messages << " messages";
+  }
 }
 
 void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
@@ -30,11 +44,37 @@ void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
   conn->send(buf);
 }
 
+// reports go to stdout, the log level stays WARN
+void printStats(EventLoop* loop)
+{
+  const EventLoop::SyscallStats& stats = loop->syscallStats();
+  printf("loop %p syscalls: %" PRId64 " poll, %" PRId64 " epoll_ctl, "
+         "%" PRId64 " read, %" PRId64 " write\n",
+         static_cast<void*>(loop), loop->iteration(), stats.pollerUpdates, stats.reads, stats.writes);
+}
+
+// reads counters of all I/O loops, from the acceptor loop
+void printServerStats(TcpServer* server)
+{
+  ConnectionStats stats = server->connectionStats();
+  printf("%s traffic: %" PRId64 " bytes in, %" PRId64 " bytes out, "
+         "%" PRId64 " messages, %" PRId64 " us in callback, "
+         "%" PRId64 " connections closed\n",
+         server->name().c_str(), stats.bytesReceived, stats.bytesSent,
+         stats.messages, stats.messageMicros, g_closedConnections.get());
+  fflush(stdout);
+}
+
+void threadInit(EventLoop* loop)
+{
+  loop->runEvery(10.0, boost::bind(printStats, loop));
+}
+
 int main(int argc, char* argv[])
 {
   if (argc < 4)
   {
-    fprintf(stderr, "Usage: server <address> <port> <threads>\n");
+    fprintf(stderr, "Usage: server <address> <port> <threads> [et]\n");
   }
   else
   {
@@ -52,6 +92,8 @@ int main(int argc, char* argv[])
 
     server.setConnectionCallback(onConnection);
     server.setMessageCallback(onMessage);
+    server.setThreadInitCallback(threadInit);
+    server.setEdgeTriggered(argc > 4 && strcmp(argv[4], "et") == 0);
 
     if (threadCount > 1)
     {
@@ -59,6 +101,7 @@ int main(int argc, char* argv[])
     }
 
     server.start();
+    loop.runEvery(10.0, boost::bind(printServerStats, &server));
 
     loop.loop();
   }
@@ -0,0 +1,158 @@
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/TcpServer.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// Round trip latency of one connection over IPv4, IPv6 and Unix-domain
+// loopback, one frame in flight at a time, like roundtrip.cc.
+
+const size_t frameLen = 2*sizeof(int64_t);
+const int kWarmUp = 1000;
+
+void serverMessageCallback(const TcpConnectionPtr& conn,
+                           Buffer* buffer,
+                           Timestamp)
+{
+  while (buffer->readableBytes() >= frameLen)
+  {
+    conn->send(buffer->peek(), frameLen);
+    buffer->retrieve(frameLen);
+  }
+}
+
+void runServer(const char* name, const InetAddress& listenAddr,
+               EventLoop** serverLoop, CountDownLatch* latch)
+{
+  EventLoop loop;
+  TcpServer server(&loop, listenAddr, name);
+  server.setMessageCallback(serverMessageCallback);
+  server.start();
+  *serverLoop = &loop;
+  latch->countDown();
+  loop.loop();
+}
+
+class Pinger : boost::noncopyable
+{
+ public:
+  Pinger(EventLoop* loop, const InetAddress& serverAddr, int rounds)
+    : loop_(loop),
+      client_(loop, serverAddr, "Pinger"),
+      rounds_(rounds)
+  {
+    rtts_.reserve(rounds);
+    client_.setConnectionCallback(
+        boost::bind(&Pinger::onConnection, this, _1));
+    client_.setMessageCallback(
+        boost::bind(&Pinger::onMessage, this, _1, _2, _3));
+  }
+
+  void connect() { client_.connect(); }
+  std::vector<int64_t>& rtts() { return rtts_; }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      conn->setTcpNoDelay(true);  // fails harmlessly on Unix-domain
+      ping(conn);
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr& conn, Buffer* buffer, Timestamp)
+  {
+    while (buffer->readableBytes() >= frameLen)
+    {
+      int64_t message[2];
+      memcpy(message, buffer->peek(), frameLen);
+      buffer->retrieve(frameLen);
+      rtts_.push_back(Timestamp::now().microSecondsSinceEpoch() - message[0]);
+    }
+    if (static_cast<int>(rtts_.size()) < rounds_ + kWarmUp)
+    {
+      ping(conn);
+    }
+    else
+    {
+      client_.disconnect();
+      loop_->quit();
+    }
+  }
+
+  void ping(const TcpConnectionPtr& conn)
+  {
+    int64_t message[2] = { Timestamp::now().microSecondsSinceEpoch(), 0 };
+    conn->send(message, sizeof message);
+  }
+
+  EventLoop* loop_;
+  TcpClient client_;
+  const int rounds_;
+  std::vector<int64_t> rtts_;
+};
+
+void bench(const char* name, const InetAddress& listenAddr,
+           const InetAddress& serverAddr, int rounds)
+{
+  std::vector<int64_t> rtts;
+  EventLoop* serverLoop = NULL;
+  CountDownLatch latch(1);
+  Thread serverThread(boost::bind(runServer, name, listenAddr, &serverLoop, &latch));
+  serverThread.start();
+  latch.wait();
+
+  {
+    EventLoop loop;
+    Pinger pinger(&loop, serverAddr, rounds);
+    pinger.connect();
+    loop.loop();
+    rtts.swap(pinger.rtts());
+  }
+  serverLoop->quit();
+  serverThread.join();
+
+  rtts.erase(rtts.begin(), rtts.begin() + kWarmUp);
+  std::sort(rtts.begin(), rtts.end());
+  int64_t sum = 0;
+  for (size_t i = 0; i < rtts.size(); ++i)
+  {
+    sum += rtts[i];
+  }
+  printf("%-6s %8d rounds  avg %6.2f  p50 %4lld  p99 %4lld  p99.9 %4lld us\n",
+         name, rounds, static_cast<double>(sum) / static_cast<double>(rtts.size()),
+         static_cast<long long>(rtts[rtts.size() / 2]),
+         static_cast<long long>(rtts[rtts.size() * 99 / 100]),
+         static_cast<long long>(rtts[rtts.size() * 999 / 1000]));
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("Usage: %s <rounds> [port] [unix_path]\n", argv[0]);
+    return 0;
+  }
+  Logger::setLogLevel(Logger::WARN);
+  int rounds = atoi(argv[1]);
+  uint16_t port = static_cast<uint16_t>(argc > 2 ? atoi(argv[2]) : 2097);
+  string path = argc > 3 ? argv[3] : "/tmp/roundtrip_bench.sock";
+
+  bench("tcp4", InetAddress(port), InetAddress("127.0.0.1", port), rounds);
+  bench("tcp6", InetAddress(port, true), InetAddress("::1", port), rounds);
+  InetAddress unixAddr(InetAddress::unixDomain(path));
+  bench("unix", unixAddr, unixAddr, rounds);
+}
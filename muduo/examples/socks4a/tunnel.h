@@ -14,11 +14,17 @@ class Tunnel : public boost::enable_shared_from_this<Tunnel>,
                boost::noncopyable
 {
  public:
+  enum ServerClient
+  {
+    kServer, kClient
+  };
+
   Tunnel(muduo::net::EventLoop* loop,
          const muduo::net::InetAddress& serverAddr,
          const muduo::net::TcpConnectionPtr& serverConn)
     : client_(loop, serverAddr, serverConn->name()),
-      serverConn_(serverConn)
+      serverConn_(serverConn),
+      splice_(false)
   {
     LOG_INFO << "Tunnel";
   }
@@ -28,6 +34,12 @@ class Tunnel : public boost::enable_shared_from_this<Tunnel>,
     LOG_INFO << "~Tunnel";
   }
 
+  // relay with splice(2), bytes never come to user space
+  void setSplice(bool on)
+  {
+    splice_ = on;
+  }
+
   void setup()
   {
     client_.setConnectionCallback(
@@ -35,8 +47,11 @@ class Tunnel : public boost::enable_shared_from_this<Tunnel>,
     client_.setMessageCallback(
         boost::bind(&Tunnel::onClientMessage, shared_from_this(), _1, _2, _3));
     serverConn_->setHighWaterMarkCallback(
-        boost::bind(&Tunnel::onHighWaterMarkWeak, boost::weak_ptr<Tunnel>(shared_from_this()), _1, _2),
-        10*1024*1024);
+        boost::bind(&Tunnel::onHighWaterMarkWeak,
+                    boost::weak_ptr<Tunnel>(shared_from_this()), kServer, _1, _2),
+        kHighMark);
+    // nowhere to send it yet
+    serverConn_->stopRead();
   }
 
   void teardown()
@@ -46,6 +61,8 @@ class Tunnel : public boost::enable_shared_from_this<Tunnel>,
     if (serverConn_)
     {
       serverConn_->setContext(boost::any());
+      // must see its FIN, even if it was held back
+      serverConn_->startRead();
       serverConn_->shutdown();
     }
   }
@@ -57,6 +74,11 @@ class Tunnel : public boost::enable_shared_from_this<Tunnel>,
 
   void disconnect()
   {
+    muduo::net::TcpConnectionPtr clientConn = client_.connection();
+    if (clientConn)
+    {
+      clientConn->startRead();
+    }
     client_.disconnect();
     // serverConn_.reset();
   }
@@ -68,13 +90,21 @@ class Tunnel : public boost::enable_shared_from_this<Tunnel>,
     {
       conn->setTcpNoDelay(true);
       conn->setHighWaterMarkCallback(
-          boost::bind(&Tunnel::onHighWaterMarkWeak, boost::weak_ptr<Tunnel>(shared_from_this()), _1, _2),
-          10*1024*1024);
+          boost::bind(&Tunnel::onHighWaterMarkWeak,
+                      boost::weak_ptr<Tunnel>(shared_from_this()), kClient, _1, _2),
+          kHighMark);
       serverConn_->setContext(conn);
-      if (serverConn_->inputBuffer()->readableBytes() > 0)
+      if (splice_)
+      {
+        // the pipes hold back a fast sender, no high water mark needed
+        serverConn_->spliceTo(conn);
+        conn->spliceTo(serverConn_);
+      }
+      else if (serverConn_->inputBuffer()->readableBytes() > 0)
       {
         conn->send(serverConn_->inputBuffer());
       }
+      serverConn_->startRead();
     }
     else
     {
@@ -98,28 +128,81 @@ class Tunnel : public boost::enable_shared_from_this<Tunnel>,
     }
   }
 
-  void onHighWaterMark(const muduo::net::TcpConnectionPtr& conn,
+  // a slow reader on one side holds back the writer on the other side
+  void onHighWaterMark(ServerClient which,
+                       const muduo::net::TcpConnectionPtr& conn,
                        size_t bytesToSent)
   {
-    LOG_INFO << "onHighWaterMark " << conn->name()
+    LOG_INFO << (which == kServer ? "server" : "client")
+             << " onHighWaterMark " << conn->name()
              << " bytes " << bytesToSent;
-    disconnect();
+    if (which == kServer)
+    {
+      if (client_.connection())
+      {
+        client_.connection()->stopRead();
+        conn->setWriteCompleteCallback(
+            boost::bind(&Tunnel::onWriteCompleteWeak,
+                        boost::weak_ptr<Tunnel>(shared_from_this()), kServer, _1));
+      }
+    }
+    else
+    {
+      serverConn_->stopRead();
+      conn->setWriteCompleteCallback(
+          boost::bind(&Tunnel::onWriteCompleteWeak,
+                      boost::weak_ptr<Tunnel>(shared_from_this()), kClient, _1));
+    }
   }
 
   static void onHighWaterMarkWeak(const boost::weak_ptr<Tunnel>& wkTunnel,
+                                  ServerClient which,
                                   const muduo::net::TcpConnectionPtr& conn,
                                   size_t bytesToSent)
   {
     boost::shared_ptr<Tunnel> tunnel = wkTunnel.lock();
     if (tunnel)
     {
-      tunnel->onHighWaterMark(conn, bytesToSent);
+      tunnel->onHighWaterMark(which, conn, bytesToSent);
+    }
+  }
+
+  void onWriteComplete(ServerClient which, const muduo::net::TcpConnectionPtr& conn)
+  {
+    LOG_INFO << (which == kServer ? "server" : "client")
+             << " onWriteComplete " << conn->name();
+    if (which == kServer)
+    {
+      if (client_.connection())
+      {
+        client_.connection()->startRead();
+      }
+    }
+    else
+    {
+      serverConn_->startRead();
+    }
+    // once per high water mark
+    conn->setWriteCompleteCallback(muduo::net::WriteCompleteCallback());
+  }
+
+  static void onWriteCompleteWeak(const boost::weak_ptr<Tunnel>& wkTunnel,
+                                  ServerClient which,
+                                  const muduo::net::TcpConnectionPtr& conn)
+  {
+    boost::shared_ptr<Tunnel> tunnel = wkTunnel.lock();
+    if (tunnel)
+    {
+      tunnel->onWriteComplete(which, conn);
     }
   }
 
  private:
+  static const size_t kHighMark = 1024*1024;
+
   muduo::net::TcpClient client_;
   muduo::net::TcpConnectionPtr serverConn_;
+  bool splice_;
 };
 typedef boost::shared_ptr<Tunnel> TunnelPtr;
 
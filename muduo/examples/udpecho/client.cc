@@ -0,0 +1,93 @@
+#include <muduo/net/UdpClient.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// keeps a window of datagrams in flight per client, echoing back
+// whatever returns.  UDP may lose some, which shrinks the window.
+
+void onMessage(UdpClient* client,
+               const InetAddress&,
+               const char* data,
+               size_t len,
+               Timestamp)
+{
+  client->send(data, len);
+}
+
+void quit(EventLoop* loop, boost::ptr_vector<UdpClient>* clients, double seconds)
+{
+  DatagramStats total = { 0, 0, 0, 0, 0 };
+  for (size_t i = 0; i < clients->size(); ++i)
+  {
+    const DatagramStats& stats = (*clients)[i].stats();
+    total.receiveCalls += stats.receiveCalls;
+    total.datagramsReceived += stats.datagramsReceived;
+    total.sendCalls += stats.sendCalls;
+    total.datagramsSent += stats.datagramsSent;
+    total.datagramsDropped += stats.datagramsDropped;
+  }
+  printf("%.0f datagrams/s received\n", static_cast<double>(total.datagramsReceived) / seconds);
+  printf("%.2f datagrams per recvmmsg, %.2f per sendmmsg, %lld dropped\n",
+         static_cast<double>(total.datagramsReceived) / static_cast<double>(total.receiveCalls),
+         static_cast<double>(total.datagramsSent) / static_cast<double>(total.sendCalls),
+         static_cast<long long>(total.datagramsDropped));
+  loop->quit();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 7)
+  {
+    fprintf(stderr, "Usage: udpecho_client <host_ip> <port> <clients> <window> <size> <seconds> [batch]\n");
+  }
+  else
+  {
+    LOG_INFO << "pid = " << getpid();
+    Logger::setLogLevel(Logger::WARN);
+
+    const char* ip = argv[1];
+    uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
+    int clientCount = atoi(argv[3]);
+    int window = atoi(argv[4]);
+    int size = atoi(argv[5]);
+    double seconds = atof(argv[6]);
+    int batch = argc > 7 ? atoi(argv[7]) : 0;
+
+    EventLoop loop;
+    InetAddress serverAddr(ip, port);
+    string message(size, 'u');
+
+    boost::ptr_vector<UdpClient> clients;
+    for (int i = 0; i < clientCount; ++i)
+    {
+      char buf[32];
+      snprintf(buf, sizeof buf, "UdpEcho%d", i);
+      UdpClient* client = new UdpClient(&loop, serverAddr, buf);
+      clients.push_back(client);
+      if (batch > 0)
+      {
+        client->setBatchSize(batch);
+      }
+      client->setMessageCallback(boost::bind(onMessage, client, _1, _2, _3, _4));
+      client->connect();
+      for (int j = 0; j < window; ++j)
+      {
+        client->send(message);
+      }
+    }
+
+    loop.runAfter(seconds, boost::bind(quit, &loop, &clients, seconds));
+    loop.loop();
+  }
+}
@@ -0,0 +1,57 @@
+#include <muduo/net/UdpServer.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+
+#include <boost/bind.hpp>
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+void onMessage(UdpServer* server,
+               const InetAddress& peer,
+               const char* data,
+               size_t len,
+               Timestamp)
+{
+  server->send(peer, data, len);
+}
+
+void printStats(UdpServer* server)
+{
+  const DatagramStats& stats = server->stats();
+  LOG_WARN << stats.datagramsReceived << " received in "
+           << stats.receiveCalls << " recvmmsg, "
+           << stats.datagramsSent << " sent in "
+           << stats.sendCalls << " sendmmsg, "
+           << stats.datagramsDropped << " dropped";
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: udpecho_server <port> [batch]\n");
+  }
+  else
+  {
+    LOG_INFO << "pid = " << getpid();
+    Logger::setLogLevel(Logger::WARN);
+
+    uint16_t port = static_cast<uint16_t>(atoi(argv[1]));
+    EventLoop loop;
+    UdpServer server(&loop, InetAddress(port), "UdpEcho");
+    if (argc > 2)
+    {
+      server.setBatchSize(atoi(argv[2]));
+    }
+    server.setMessageCallback(boost::bind(onMessage, &server, _1, _2, _3, _4));
+    server.start();
+    loop.runEvery(10.0, boost::bind(printStats, &server));
+    loop.loop();
+  }
+}
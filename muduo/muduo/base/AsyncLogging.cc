@@ -1,45 +1,338 @@
 #include <muduo/base/AsyncLogging.h>
-#include <muduo/base/LogFile.h>
+#include <muduo/base/Logging.h>
 #include <muduo/base/Timestamp.h>
 
+#include <algorithm>
+
 #include <stdio.h>
 
 using namespace muduo;
 
+///
+/// Log lines and records from one thread, waiting for the background thread.
+///
+/// Each entry is an int header, the length of a line, or minus the length
+/// of a Logger::logf() record, followed by its bytes.
+///
+/// head_ is written by the producer only, tail_ by the consumer only,
+/// under mutex_.  Each loads the other's with acquire and publishes its
+/// own with release, so the producer never locks.
+class AsyncLogging::Staging : boost::noncopyable
+{
+ public:
+  static const size_t kSize = 64*1024;  // power of 2
+
+  Staging()
+    : head_(0),
+      tail_(0),
+      orphaned_(0)
+  {
+  }
+
+  /// @return false if it doesn't fit
+  bool put(int header, const char* data, size_t len, bool* halfFull)
+  {
+    size_t head = head_;
+    size_t tail = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+    size_t total = sizeof header + len;
+    if (head - tail + total > kSize)
+    {
+      return false;
+    }
+    copyIn(head, &header, sizeof header);
+    copyIn(head + sizeof header, data, len);
+    __atomic_store_n(&head_, head + total, __ATOMIC_RELEASE);
+    *halfFull = head - tail < kSize/2 && head + total - tail >= kSize/2;
+    return true;
+  }
+
+  size_t readableBytes() const
+  {
+    return __atomic_load_n(&head_, __ATOMIC_ACQUIRE) - tail_;
+  }
+
+  int peekHeader() const
+  {
+    int header = 0;
+    copyOut(tail_, &header, sizeof header);
+    return header;
+  }
+
+  // of the first entry, copied to @c scratch if it wraps around
+  const char* peekData(size_t len, std::vector<char>* scratch) const
+  {
+    size_t pos = (tail_ + sizeof(int)) & (kSize-1);
+    if (pos + len <= kSize)
+    {
+      return data_ + pos;
+    }
+    scratch->resize(len);
+    copyOut(tail_ + sizeof(int), &*scratch->begin(), len);
+    return &*scratch->begin();
+  }
+
+  void retrieve(size_t len)
+  {
+    __atomic_store_n(&tail_, tail_ + len, __ATOMIC_RELEASE);
+  }
+
+  void orphan() { __atomic_store_n(&orphaned_, 1, __ATOMIC_RELEASE); }
+  bool orphaned() const { return __atomic_load_n(&orphaned_, __ATOMIC_ACQUIRE); }
+
+ private:
+  void copyIn(size_t at, const void* src, size_t len)
+  {
+    size_t pos = at & (kSize-1);
+    size_t first = std::min(len, kSize - pos);
+    memcpy(data_ + pos, src, first);
+    memcpy(data_, static_cast<const char*>(src) + first, len - first);
+  }
+
+  void copyOut(size_t at, void* dst, size_t len) const
+  {
+    size_t pos = at & (kSize-1);
+    size_t first = std::min(len, kSize - pos);
+    memcpy(dst, data_ + pos, first);
+    memcpy(static_cast<char*>(dst) + first, data_, len - first);
+  }
+
+  // on cache lines of their own, the two threads don't fight for them
+  size_t head_;
+  char pad1_[64 - sizeof(size_t)];
+  size_t tail_;
+  char pad2_[64 - sizeof(size_t)];
+  int orphaned_;
+  char data_[kSize];
+};
+
+const size_t AsyncLogging::Staging::kSize;
+const int AsyncLogging::kDefaultMaxBuffers;
+
+namespace
+{
+
+// "20130510 03:27:30.123456Z  1234 INFO  message - file.cc:42\n"
+Logger::LogLevel levelOf(const char* logline, int len)
+{
+  const char* p = logline + 26;  // tid
+  const char* end = logline + len;
+  while (p < end && *p == ' ')
+  {
+    ++p;
+  }
+  while (p < end && *p >= '0' && *p <= '9')
+  {
+    ++p;
+  }
+  ++p;
+  for (int level = 0; p + 6 <= end && level < Logger::NUM_LOG_LEVELS; ++level)
+  {
+    if (memcmp(p, LogLevelName[level], 6) == 0)
+    {
+      return static_cast<Logger::LogLevel>(level);
+    }
+  }
+  // not from Logger
+  return Logger::INFO;
+}
+
+}
+
+AsyncLogging::StagingRef::~StagingRef()
+{
+  if (staging)
+  {
+    staging->orphan();
+  }
+}
+
 AsyncLogging::AsyncLogging(const string& basename,
                            size_t rollSize,
                            int flushInterval)
   : flushInterval_(flushInterval),
     running_(false),
+    threadStaging_(true),
+    fileOptions_(LogFile::kUnbuffered),
+    compress_(false),
+    maxFiles_(0),
+    maxBytes_(0),
+    allProcesses_(false),
     basename_(basename),
     rollSize_(rollSize),
     thread_(boost::bind(&AsyncLogging::threadFunc, this), "Logging"),
     latch_(1),
     mutex_(),
     cond_(mutex_),
+    notFull_(mutex_),
+    policy_(kDropNew),
+    maxBuffers_(kDefaultMaxBuffers),
+    sampleRate_(100),
+    sampled_(0),
+    buffersWriting_(0),
     currentBuffer_(new Buffer),
     nextBuffer_(new Buffer),
     buffers_()
 {
+  bzero(&stats_, sizeof stats_);
   currentBuffer_->bzero();
   nextBuffer_->bzero();
   buffers_.reserve(16);
 }
 
+AsyncLogging::~AsyncLogging()
+{
+  if (running_)
+  {
+    stop();
+  }
+  for (size_t i = 0; i < stagings_.size(); ++i)
+  {
+    delete stagings_[i];
+  }
+}
+
 void AsyncLogging::append(const char* logline, int len)
 {
+  Staging* staging = threadStaging_ ? threadStaging() : NULL;
+  if (staging && stage(staging, len, logline, len))
+  {
+    return;
+  }
   muduo::MutexLockGuard lock(mutex_);
+  if (admitLocked(logline, len, true))
+  {
+    if (staging)
+    {
+      // ring is full, what's in it goes first
+      drainLocked(staging, false);
+    }
+    appendLocked(logline, len);
+  }
+}
+
+void AsyncLogging::appendRecord(const char* record, int len)
+{
+  Staging* staging = threadStaging_ ? threadStaging() : NULL;
+  if (staging && stage(staging, -len, record, len))
+  {
+    return;
+  }
+  LogStream stream;
+  Logger::formatRecord(record, len, stream);
+  muduo::MutexLockGuard lock(mutex_);
+  if (admitLocked(stream.buffer().data(), stream.buffer().length(), true))
+  {
+    if (staging)
+    {
+      drainLocked(staging, false);
+    }
+    appendLocked(stream.buffer().data(), stream.buffer().length());
+  }
+}
+
+void AsyncLogging::setOverloadPolicy(OverloadPolicy policy, int maxBuffers, int sampleRate)
+{
+  assert(!running_);
+  assert(maxBuffers > 0 && sampleRate > 0);
+  policy_ = policy;
+  maxBuffers_ = maxBuffers;
+  sampleRate_ = sampleRate;
+}
+
+AsyncLogging::OverloadStats AsyncLogging::overloadStats() const
+{
+  muduo::MutexLockGuard lock(mutex_);
+  return stats_;
+}
+
+AsyncLogging::Staging* AsyncLogging::threadStaging()
+{
+  StagingRef& ref = staging_.value();
+  if (!ref.staging)
+  {
+    Staging* staging = new Staging;
+    muduo::MutexLockGuard lock(mutex_);
+    stagings_.push_back(staging);
+    ref.staging = staging;
+  }
+  return ref.staging;
+}
+
+bool AsyncLogging::stage(Staging* staging, int header, const char* data, int len)
+{
+  bool halfFull = false;
+  if (!staging->put(header, data, len, &halfFull))
+  {
+    return false;
+  }
+  if (halfFull)
+  {
+    // under the lock, so the background thread can't miss it
+    muduo::MutexLockGuard lock(mutex_);
+    cond_.notify();
+  }
+  return true;
+}
+
+bool AsyncLogging::admitLocked(const char* logline, int len, bool mayWait)
+{
+  // counts those being written as well
+  size_t queued = buffers_.size() + buffersWriting_;
+  if (queued < (policy_ == kSample ? maxBuffers_/2 : maxBuffers_))
+  {
+    return true;
+  }
+  bool full = queued >= maxBuffers_;
+  Logger::LogLevel level = levelOf(logline, len);
+  switch (policy_)
+  {
+    case kDropNew:
+      if (!full)
+        return true;
+      break;
+    case kSample:
+      if (!full && ++sampled_ % sampleRate_ == 0)
+        return true;
+      break;
+    case kKeepWarn:
+    case kBlock:
+      if (!full)
+        return true;
+      if (policy_ == kKeepWarn && level < Logger::WARN)
+        break;
+      if (!mayWait)
+        return true;
+      {
+        Timestamp start(Timestamp::now());
+        while (running_ && buffers_.size() + buffersWriting_ >= maxBuffers_)
+        {
+          notFull_.wait();
+        }
+        ++stats_.blocked;
+        stats_.blockedMicros += Timestamp::now().microSecondsSinceEpoch()
+                                - start.microSecondsSinceEpoch();
+      }
+      return true;
+  }
+  ++stats_.droppedLines[level];
+  stats_.droppedBytes[level] += len;
+  return false;
+}
+
+void AsyncLogging::appendLocked(const char* logline, int len)
+{
   if (currentBuffer_->avail() > len)
   {
     currentBuffer_->append(logline, len);
   }
   else
   {
-    buffers_.push_back(currentBuffer_.release());
+    buffers_.push_back(currentBuffer_);
+    currentBuffer_.reset();
 
     if (nextBuffer_)
     {
-      currentBuffer_ = boost::ptr_container::move(nextBuffer_);
+      currentBuffer_.swap(nextBuffer_);
     }
     else
     {
@@ -50,56 +343,146 @@ void AsyncLogging::append(const char* logline, int len)
   }
 }
 
+bool AsyncLogging::drainLocked(Staging* staging, bool bounded)
+{
+  size_t readable = staging->readableBytes();
+  while (readable > 0)
+  {
+    if (bounded && buffers_.size() + buffersWriting_ >= maxBuffers_)
+    {
+      return false;
+    }
+    int header = staging->peekHeader();
+    int len = header >= 0 ? header : -header;
+    const char* data = staging->peekData(len, &scratch_);
+    // never waits, the ring's thread did if the policy says so
+    if (header >= 0)
+    {
+      if (admitLocked(data, len, false))
+      {
+        appendLocked(data, len);
+      }
+    }
+    else
+    {
+      LogStream stream;
+      Logger::formatRecord(data, len, stream);
+      if (admitLocked(stream.buffer().data(), stream.buffer().length(), false))
+      {
+        appendLocked(stream.buffer().data(), stream.buffer().length());
+      }
+    }
+    staging->retrieve(sizeof header + len);
+    readable -= sizeof header + len;
+  }
+  return true;
+}
+
+void AsyncLogging::harvestLocked(bool bounded)
+{
+  size_t i = 0;
+  while (i < stagings_.size())
+  {
+    Staging* staging = stagings_[i];
+    // its thread is gone, nothing comes after this drain
+    bool orphaned = staging->orphaned();
+    if (!drainLocked(staging, bounded))
+    {
+      // the rest waits in the rings
+      return;
+    }
+    if (orphaned)
+    {
+      delete staging;
+      stagings_[i] = stagings_.back();
+      stagings_.pop_back();
+    }
+    else
+    {
+      ++i;
+    }
+  }
+}
+
+bool AsyncLogging::stagingHalfFullLocked() const
+{
+  for (size_t i = 0; i < stagings_.size(); ++i)
+  {
+    if (stagings_[i]->readableBytes() >= Staging::kSize/2)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 void AsyncLogging::threadFunc()
 {
   assert(running_ == true);
   latch_.countDown();
-  LogFile output(basename_, rollSize_, false);
+  LogFile output(basename_, rollSize_, false, flushInterval_, fileOptions_);
+  output.setArchiving(compress_, maxFiles_, maxBytes_, allProcesses_);
   BufferPtr newBuffer1(new Buffer);
   BufferPtr newBuffer2(new Buffer);
   newBuffer1->bzero();
   newBuffer2->bzero();
   BufferVector buffersToWrite;
   buffersToWrite.reserve(16);
+  std::vector<struct iovec> iov;
+  int64_t reportedDrops = 0;
   while (running_)
   {
     assert(newBuffer1 && newBuffer1->length() == 0);
     assert(newBuffer2 && newBuffer2->length() == 0);
     assert(buffersToWrite.empty());
 
+    int64_t droppedLines = 0;
+    int64_t droppedBytes = 0;
     {
       muduo::MutexLockGuard lock(mutex_);
-      if (buffers_.empty())  // unusual usage!
+      if (buffers_.empty() && !stagingHalfFullLocked())  // unusual usage!
       {
         cond_.waitForSeconds(flushInterval_);
       }
-      buffers_.push_back(currentBuffer_.release());
-      currentBuffer_ = boost::ptr_container::move(newBuffer1);
+      harvestLocked(true);
+      buffers_.push_back(currentBuffer_);
+      currentBuffer_.reset();
+      currentBuffer_.swap(newBuffer1);
       buffersToWrite.swap(buffers_);
       if (!nextBuffer_)
       {
-        nextBuffer_ = boost::ptr_container::move(newBuffer2);
+        nextBuffer_.swap(newBuffer2);
+      }
+      buffersWriting_ = buffersToWrite.size();
+      for (int level = 0; level < Logger::NUM_LOG_LEVELS; ++level)
+      {
+        droppedLines += stats_.droppedLines[level];
+        droppedBytes += stats_.droppedBytes[level];
       }
     }
 
     assert(!buffersToWrite.empty());
 
-    if (buffersToWrite.size() > 25)
+    if (droppedLines > reportedDrops)
     {
       char buf[256];
-      snprintf(buf, sizeof buf, "Dropped log messages at %s, %zd larger buffers\n",
+      snprintf(buf, sizeof buf, "Dropped %lld log lines at %s, %lld in total, %lld bytes\n",
+               static_cast<long long>(droppedLines - reportedDrops),
                Timestamp::now().toFormattedString().c_str(),
-               buffersToWrite.size()-2);
+               static_cast<long long>(droppedLines),
+               static_cast<long long>(droppedBytes));
       fputs(buf, stderr);
       output.append(buf, static_cast<int>(strlen(buf)));
-      buffersToWrite.erase(buffersToWrite.begin()+2, buffersToWrite.end());
+      reportedDrops = droppedLines;
     }
 
+    iov.resize(buffersToWrite.size());
     for (size_t i = 0; i < buffersToWrite.size(); ++i)
     {
-      // FIXME: use unbuffered stdio FILE ? or use ::writev ?
-      output.append(buffersToWrite[i].data(), buffersToWrite[i].length());
+      iov[i].iov_base = const_cast<char*>(buffersToWrite[i]->data());
+      iov[i].iov_len = buffersToWrite[i]->length();
     }
+    output.appendv(&*iov.begin(), static_cast<int>(iov.size()));
 
     if (buffersToWrite.size() > 2)
     {
@@ -107,23 +490,41 @@ void AsyncLogging::threadFunc()
       buffersToWrite.resize(2);
     }
 
+    {
+      muduo::MutexLockGuard lock(mutex_);
+      buffersWriting_ = 0;
+      notFull_.notifyAll();
+    }
+
     if (!newBuffer1)
     {
       assert(!buffersToWrite.empty());
-      newBuffer1 = buffersToWrite.pop_back();
+      newBuffer1 = buffersToWrite.back();
+      buffersToWrite.pop_back();
       newBuffer1->reset();
     }
 
     if (!newBuffer2)
     {
       assert(!buffersToWrite.empty());
-      newBuffer2 = buffersToWrite.pop_back();
+      newBuffer2 = buffersToWrite.back();
+      buffersToWrite.pop_back();
       newBuffer2->reset();
     }
 
     buffersToWrite.clear();
     output.flush();
   }
+
+  // what's left after stop()
+  muduo::MutexLockGuard lock(mutex_);
+  harvestLocked(false);
+  for (size_t i = 0; i < buffers_.size(); ++i)
+  {
+    output.append(buffers_[i]->data(), buffers_[i]->length());
+  }
+  buffers_.clear();
+  output.append(currentBuffer_->data(), currentBuffer_->length());
+  currentBuffer_->reset();
   output.flush();
 }
-
@@ -4,36 +4,101 @@
 #include <muduo/base/BlockingQueue.h>
 #include <muduo/base/BoundedBlockingQueue.h>
 #include <muduo/base/CountDownLatch.h>
+#include <muduo/base/LogFile.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
+#include <muduo/base/ThreadLocal.h>
 
+#include <muduo/base/Logging.h>
 #include <muduo/base/LogStream.h>
 
 #include <boost/bind.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
-#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
 
 namespace muduo
 {
 
+///
+/// Writes log lines to LogFile in a background thread.
+///
+/// Each thread appends to a ring of its own without taking a lock, the
+/// background thread harvests the rings, and formats records of LOG_*F.
+/// When a ring is full, or with setThreadStaging(false), lines go to
+/// buffers shared under a mutex.
+///
+/// When the background thread falls behind, at most maxBuffers full
+/// buffers are queued or being written, OverloadPolicy says what happens
+/// to the rest.  Lines in the rings go by it when harvested; once the
+/// queue is full they wait there, and a thread whose ring is full meets
+/// the policy itself.  Its ring is then moved over whole, which may
+/// queue one buffer past maxBuffers.
 class AsyncLogging : boost::noncopyable
 {
  public:
+  enum OverloadPolicy
+  {
+    kDropNew,   // drops lines that don't fit
+    kBlock,     // waits for the background thread
+    kKeepWarn,  // drops lines below WARN, waits for the others
+    kSample,    // keeps 1 of sampleRate lines past half of maxBuffers,
+                // drops all when full
+  };
+
+  static const int kDefaultMaxBuffers = 25;  // of 4 MB
+
+  /// Counted since start(), when lines don't fit.
+  struct OverloadStats
+  {
+    int64_t droppedLines[Logger::NUM_LOG_LEVELS];
+    int64_t droppedBytes[Logger::NUM_LOG_LEVELS];
+    int64_t blocked;          // appends that waited
+    int64_t blockedMicros;
+  };
 
   AsyncLogging(const string& basename,
                size_t rollSize,
                int flushInterval = 3);
 
-  ~AsyncLogging()
+  ~AsyncLogging();
+
+  /// Thread safe.  Lines of one thread keep their order.
+  void append(const char* logline, int len);
+
+  /// Thread safe.  Takes a record of Logger::logf(), formats it in the
+  /// background thread, for Logger::setRecordOutput().
+  void appendRecord(const char* record, int len);
+
+  /// On by default, must be called before start().
+  void setThreadStaging(bool on) { threadStaging_ = on; }
+
+  /// LogFile::Option, LogFile::kUnbuffered by default, so buffers are
+  /// written by one writev(2).  Must be called before start().
+  void setFileOptions(int options) { fileOptions_ = options; }
+
+  /// See LogFile::setArchiving(), off by default, must be called before start().
+  void setArchiving(bool compress, int maxFiles = 0, int64_t maxBytes = 0,
+                    bool allProcesses = false)
   {
-    if (running_)
-    {
-      stop();
-    }
+    compress_ = compress;
+    maxFiles_ = maxFiles;
+    maxBytes_ = maxBytes;
+    allProcesses_ = allProcesses;
   }
 
-  void append(const char* logline, int len);
+  /// kDropNew with kDefaultMaxBuffers by default, must be called before start().
+  void setOverloadPolicy(OverloadPolicy policy,
+                         int maxBuffers = kDefaultMaxBuffers,
+                         int sampleRate = 100);
+
+  OverloadPolicy overloadPolicy() const { return policy_; }
+  int maxBuffers() const { return static_cast<int>(maxBuffers_); }
+
+  /// Thread safe.
+  OverloadStats overloadStats() const;
 
   void start()
   {
@@ -46,32 +111,64 @@ class AsyncLogging : boost::noncopyable
   {
     running_ = false;
     cond_.notify();
+    notFull_.notifyAll();
     thread_.join();
   }
 
  private:
 
-  // declare but not define, prevent compiler-synthesized functions
-  AsyncLogging(const AsyncLogging&);  // ptr_container
-  void operator=(const AsyncLogging&);  // ptr_container
+  typedef muduo::detail::FixedBuffer<muduo::detail::kLargeBuffer> Buffer;
+  typedef boost::shared_ptr<Buffer> BufferPtr;
+  typedef std::vector<BufferPtr> BufferVector;
 
-  void threadFunc();
+  // single producer ring of a thread, defined in .cc
+  class Staging;
+  // deleted at thread exit, leaves the ring to the background thread
+  struct StagingRef
+  {
+    StagingRef() : staging(NULL) { }
+    ~StagingRef();
+    Staging* staging;
+  };
 
-  typedef muduo::detail::FixedBuffer<muduo::detail::kLargeBuffer> Buffer;
-  typedef boost::ptr_vector<Buffer> BufferVector;
-  typedef BufferVector::auto_type BufferPtr;
+  void threadFunc();
+  Staging* threadStaging();
+  bool stage(Staging* staging, int header, const char* data, int len);
+  // with mutex_ held
+  bool admitLocked(const char* logline, int len, bool mayWait);
+  void appendLocked(const char* logline, int len);
+  // false if stopped by a full queue, with lines left
+  bool drainLocked(Staging* staging, bool bounded);
+  void harvestLocked(bool bounded);
+  bool stagingHalfFullLocked() const;
 
   const int flushInterval_;
   bool running_;
+  bool threadStaging_;
+  int fileOptions_;
+  bool compress_;
+  int maxFiles_;
+  int64_t maxBytes_;
+  bool allProcesses_;
   string basename_;
   size_t rollSize_;
   muduo::Thread thread_;
   muduo::CountDownLatch latch_;
-  muduo::MutexLock mutex_;
+  mutable muduo::MutexLock mutex_;
   muduo::Condition cond_;
+  muduo::Condition notFull_;
+  OverloadPolicy policy_;
+  size_t maxBuffers_;
+  int sampleRate_;
+  int sampled_;                // guarded by mutex_
+  size_t buffersWriting_;      // guarded by mutex_
+  OverloadStats stats_;        // guarded by mutex_
   BufferPtr currentBuffer_;
   BufferPtr nextBuffer_;
   BufferVector buffers_;
+  muduo::ThreadLocal<StagingRef> staging_;
+  std::vector<Staging*> stagings_;  // owned, guarded by mutex_
+  std::vector<char> scratch_;       // guarded by mutex_
 };
 
 }
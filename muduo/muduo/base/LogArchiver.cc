@@ -0,0 +1,229 @@
+#include <muduo/base/LogArchiver.h>
+#include <muduo/base/CurrentThread.h>
+#include <muduo/base/Logging.h> // strerror_tl
+#include <muduo/base/ProcessInfo.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace muduo;
+
+namespace
+{
+
+// from linux/ioprio.h
+const int kIoprioWhoProcess = 1;
+const int kIoprioClassIdle = 3;
+const int kIoprioClassShift = 13;
+
+// "20130411-115604" of LogFile::getLogFileName()
+const size_t kTimeLength = 15;
+
+bool isDigits(const string& str)
+{
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] < '0' || str[i] > '9')
+    {
+      return false;
+    }
+  }
+  return !str.empty();
+}
+
+}
+
+LogArchiver::LogArchiver(const string& basename, bool compress, int maxFiles, int64_t maxBytes,
+                         bool allProcesses)
+  : basename_(basename),
+    host_("." + ProcessInfo::hostname() + "."),
+    pid_(ProcessInfo::pidString()),
+    compress_(compress),
+    maxFiles_(maxFiles),
+    maxBytes_(maxBytes),
+    allProcesses_(allProcesses),
+    thread_(boost::bind(&LogArchiver::threadFunc, this), "LogArchiver")
+{
+  thread_.start();
+}
+
+LogArchiver::~LogArchiver()
+{
+  queue_.put(std::make_pair(string(), string()));
+  thread_.join();
+}
+
+void LogArchiver::archive(const string& rolled, const string& active)
+{
+  queue_.put(std::make_pair(rolled, active));
+}
+
+void LogArchiver::threadFunc()
+{
+  // takes what the writer and the rest of the process leave
+  ::setpriority(PRIO_PROCESS, CurrentThread::tid(), 19);
+  ::syscall(SYS_ioprio_set, kIoprioWhoProcess, CurrentThread::tid(),
+            kIoprioClassIdle << kIoprioClassShift);
+
+  const bool limited = maxFiles_ > 0 || maxBytes_ > 0;
+  string active;  // of the last job not retained yet
+  while (true)
+  {
+    std::pair<string, string> job = queue_.take();
+    if (job.first.empty())
+    {
+      break;
+    }
+    if (compress_)
+    {
+      compress(job.first);
+    }
+    active = job.second;
+    // if behind, one scan of the directory after the last job does for all
+    if (limited && queue_.size() == 0)
+    {
+      retain(active);
+      active.clear();
+    }
+  }
+  if (limited && !active.empty())
+  {
+    retain(active);
+  }
+}
+
+void LogArchiver::compress(const string& filename)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    fprintf(stderr, "LogArchiver: open %s failed %s\n", filename.c_str(), strerror_tl(errno));
+    return;
+  }
+  // renamed when complete, never both gone
+  string tmpname = filename + ".gz.tmp";
+  gzFile gz = ::gzopen(tmpname.c_str(), "wb1");  // logs compress well at level 1
+  if (gz == NULL)
+  {
+    fprintf(stderr, "LogArchiver: gzopen %s failed\n", tmpname.c_str());
+    ::close(fd);
+    return;
+  }
+  ::gzbuffer(gz, 256*1024);
+
+  char buf[256*1024];
+  bool ok = true;
+  off_t offset = 0;
+  ssize_t n = 0;
+  while ((n = ::read(fd, buf, sizeof buf)) > 0)
+  {
+    if (::gzwrite(gz, buf, static_cast<unsigned>(n)) != n)
+    {
+      ok = false;
+      break;
+    }
+    // read once, don't push the active file out of page cache
+    ::posix_fadvise(fd, offset, n, POSIX_FADV_DONTNEED);
+    offset += n;
+  }
+  ok = ok && n == 0;
+  ok = ::gzclose(gz) == Z_OK && ok;
+  ::close(fd);
+
+  if (ok && ::rename(tmpname.c_str(), (filename + ".gz").c_str()) == 0)
+  {
+    ::unlink(filename.c_str());
+  }
+  else
+  {
+    fprintf(stderr, "LogArchiver: compressing %s failed\n", filename.c_str());
+    ::unlink(tmpname.c_str());
+  }
+}
+
+void LogArchiver::retain(const string& active)
+{
+  // names start with the time, sorted oldest first
+  std::vector<std::pair<string, int64_t> > files;
+  DIR* dir = ::opendir(".");
+  if (dir == NULL)
+  {
+    return;
+  }
+  struct dirent* entry = NULL;
+  while ((entry = ::readdir(dir)) != NULL)
+  {
+    string name(entry->d_name);
+    if (name != active && counted(name))
+    {
+      struct stat st;
+      if (::stat(name.c_str(), &st) == 0)
+      {
+        files.push_back(std::make_pair(name, static_cast<int64_t>(st.st_size)));
+      }
+    }
+  }
+  ::closedir(dir);
+  std::sort(files.begin(), files.end());
+
+  int64_t totalBytes = 0;
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    totalBytes += files[i].second;
+  }
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    int count = static_cast<int>(files.size() - i);
+    if ((maxFiles_ > 0 && count > maxFiles_)
+        || (maxBytes_ > 0 && totalBytes > maxBytes_))
+    {
+      ::unlink(files[i].first.c_str());
+      totalBytes -= files[i].second;
+    }
+    else
+    {
+      break;
+    }
+  }
+}
+
+// basename.20130411-115604.hostname.pid.log[.gz]
+bool LogArchiver::counted(const string& name) const
+{
+  size_t pos = basename_.size() + 1;
+  if (name.size() <= pos + kTimeLength
+      || name.compare(0, basename_.size(), basename_) != 0
+      || name[basename_.size()] != '.'
+      || !isDigits(name.substr(pos, 8)))
+  {
+    return false;
+  }
+  pos += kTimeLength;
+  if (name.compare(pos, host_.size(), host_) != 0)
+  {
+    return false;
+  }
+  pos += host_.size();
+  size_t end = name.find(".log", pos);
+  if (end == string::npos)
+  {
+    return false;
+  }
+  string rest(name, end);
+  string pid(name, pos, end - pos);
+  return (rest == ".log" || rest == ".log.gz")
+      && (allProcesses_ ? isDigits(pid) : pid == pid_);
+}
@@ -0,0 +1,57 @@
+#ifndef MUDUO_BASE_LOGARCHIVER_H
+#define MUDUO_BASE_LOGARCHIVER_H
+
+#include <muduo/base/BlockingQueue.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Types.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <utility>
+
+namespace muduo
+{
+
+///
+/// Gzips files rolled by LogFile and removes the oldest, in a thread of
+/// idle CPU and IO priority, so the writer never waits for it.
+///
+/// Only files named like LogFile::getLogFileName() of @c basename and
+/// this host, in the working directory, are touched.  By default only
+/// those of this process count, files of earlier runs or of other
+/// processes are never removed.
+class LogArchiver : boost::noncopyable
+{
+ public:
+  /// Keeps at most @c maxFiles rolled files and @c maxBytes of them,
+  /// not counting the active one, 0 for no limit.  With @c allProcesses
+  /// the limits cover files of any pid, eg. of runs before a restart,
+  /// so only one process may log to @c basename in the directory.
+  LogArchiver(const string& basename, bool compress, int maxFiles, int64_t maxBytes,
+              bool allProcesses = false);
+  /// Finishes the files queued so far.
+  ~LogArchiver();
+
+  /// Never blocks.  @c rolled must be closed.
+  void archive(const string& rolled, const string& active);
+
+ private:
+  void threadFunc();
+  void compress(const string& filename);
+  void retain(const string& active);
+  bool counted(const string& name) const;
+
+  const string basename_;
+  const string host_;  // .hostname.
+  const string pid_;
+  const bool compress_;
+  const int maxFiles_;
+  const int64_t maxBytes_;
+  const bool allProcesses_;
+  // rolled and active file, empty to stop
+  BlockingQueue<std::pair<string, string> > queue_;
+  Thread thread_;
+};
+
+}
+#endif  // MUDUO_BASE_LOGARCHIVER_H
@@ -1,10 +1,18 @@
 #include <muduo/base/LogFile.h>
+#include <muduo/base/LogArchiver.h>
 #include <muduo/base/Logging.h> // strerror_tl
 #include <muduo/base/ProcessInfo.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <time.h>
+#include <unistd.h>
 
 using namespace muduo;
 
@@ -69,13 +77,139 @@ class LogFile::File : boost::noncopyable
   size_t writtenBytes_;
 };
 
+// unbuffered, not thread safe
+class LogFile::AppendFile : boost::noncopyable
+{
+ public:
+  AppendFile(const string& filename, int options, size_t preallocate)
+    : fd_(::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)),
+      syncBehind_(options & kSyncBehind),
+      offset_(0),
+      writtenBytes_(0),
+      preallocated_(0),
+      syncStarted_(0),
+      syncDone_(0)
+  {
+    assert(fd_ >= 0);
+    offset_ = ::lseek(fd_, 0, SEEK_END);
+    syncStarted_ = syncDone_ = offset_;
+    // appends go to allocated blocks, without changing the size on every
+    // write.  Some file systems can't, it's just slower then.
+    if ((options & kPreallocate)
+        && ::fallocate(fd_, FALLOC_FL_KEEP_SIZE, offset_, preallocate) == 0)
+    {
+      preallocated_ = preallocate;
+    }
+  }
+
+  ~AppendFile()
+  {
+    if (preallocated_ > writtenBytes_)
+    {
+      // gives back what wasn't used, blocks past the end are freed
+      // by truncating, even to the same size
+      if (::ftruncate(fd_, offset_ + static_cast<off_t>(writtenBytes_)) < 0)
+      {
+        fprintf(stderr, "LogFile::AppendFile ftruncate failed %s\n", strerror_tl(errno));
+      }
+    }
+    ::close(fd_);
+  }
+
+  void append(const char* logline, size_t len)
+  {
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(logline);
+    iov.iov_len = len;
+    appendv(&iov, 1);
+  }
+
+  void appendv(const struct iovec* iov, int count)
+  {
+    iov_.assign(iov, iov + count);
+    struct iovec* vec = &*iov_.begin();
+    while (count > 0)
+    {
+      ssize_t n = ::writev(fd_, vec, std::min(count, IOV_MAX));
+      if (n < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        fprintf(stderr, "LogFile::AppendFile::appendv() failed %s\n", strerror_tl(errno));
+        break;
+      }
+      writtenBytes_ += n;
+      size_t remain = static_cast<size_t>(n);
+      while (count > 0 && remain >= vec->iov_len)
+      {
+        remain -= vec->iov_len;
+        ++vec;
+        --count;
+      }
+      if (count > 0)
+      {
+        // short write
+        vec->iov_base = static_cast<char*>(vec->iov_base) + remain;
+        vec->iov_len -= remain;
+      }
+    }
+
+    if (syncBehind_)
+    {
+      syncBehind();
+    }
+  }
+
+  size_t writtenBytes() const { return writtenBytes_; }
+
+ private:
+  static const off_t kSyncWindow = 8*1024*1024;
+
+  // keeps at most two windows of dirty pages, so the kernel never has
+  // a big writeback to do at once, and written logs don't fill page cache
+  void syncBehind()
+  {
+    off_t end = offset_ + static_cast<off_t>(writtenBytes_);
+    if (end - syncStarted_ < kSyncWindow)
+    {
+      return;
+    }
+    if (syncStarted_ > syncDone_)
+    {
+      // the window before, likely written back by now
+      ::sync_file_range(fd_, syncDone_, syncStarted_ - syncDone_,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE
+                        | SYNC_FILE_RANGE_WAIT_AFTER);
+      ::posix_fadvise(fd_, syncDone_, syncStarted_ - syncDone_, POSIX_FADV_DONTNEED);
+      syncDone_ = syncStarted_;
+    }
+    ::sync_file_range(fd_, syncStarted_, end - syncStarted_, SYNC_FILE_RANGE_WRITE);
+    syncStarted_ = end;
+  }
+
+  const int fd_;
+  const bool syncBehind_;
+  off_t offset_;          // file size when opened
+  size_t writtenBytes_;
+  size_t preallocated_;
+  off_t syncStarted_;
+  off_t syncDone_;
+  std::vector<struct iovec> iov_;
+};
+
+const off_t LogFile::AppendFile::kSyncWindow;
+
 LogFile::LogFile(const string& basename,
                  size_t rollSize,
                  bool threadSafe,
-                 int flushInterval)
+                 int flushInterval,
+                 int options)
   : basename_(basename),
     rollSize_(rollSize),
     flushInterval_(flushInterval),
+    options_(options),
     count_(0),
     mutex_(threadSafe ? new MutexLock : NULL),
     startOfPeriod_(0),
@@ -103,8 +237,26 @@ void LogFile::append(const char* logline, int len)
   }
 }
 
+void LogFile::appendv(const struct iovec* iov, int count)
+{
+  if (mutex_)
+  {
+    MutexLockGuard lock(*mutex_);
+    appendv_unlocked(iov, count);
+  }
+  else
+  {
+    appendv_unlocked(iov, count);
+  }
+}
+
 void LogFile::flush()
 {
+  if (!file_)
+  {
+    // nothing buffered with kUnbuffered
+    return;
+  }
   if (mutex_)
   {
     MutexLockGuard lock(*mutex_);
@@ -116,11 +268,55 @@ void LogFile::flush()
   }
 }
 
+void LogFile::setArchiving(bool compress, int maxFiles, int64_t maxBytes, bool allProcesses)
+{
+  if (compress || maxFiles > 0 || maxBytes > 0)
+  {
+    archiver_.reset(new LogArchiver(basename_, compress, maxFiles, maxBytes, allProcesses));
+  }
+  else
+  {
+    archiver_.reset();
+  }
+}
+
+size_t LogFile::writtenBytes() const
+{
+  return appendFile_ ? appendFile_->writtenBytes() : file_->writtenBytes();
+}
+
 void LogFile::append_unlocked(const char* logline, int len)
 {
-  file_->append(logline, len);
+  if (appendFile_)
+  {
+    appendFile_->append(logline, len);
+  }
+  else
+  {
+    file_->append(logline, len);
+  }
+  rollOrFlush();
+}
+
+void LogFile::appendv_unlocked(const struct iovec* iov, int count)
+{
+  if (appendFile_)
+  {
+    appendFile_->appendv(iov, count);
+  }
+  else
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      file_->append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+  }
+  rollOrFlush();
+}
 
-  if (file_->writtenBytes() > rollSize_)
+void LogFile::rollOrFlush()
+{
+  if (writtenBytes() > rollSize_)
   {
     rollFile();
   }
@@ -138,7 +334,10 @@ void LogFile::append_unlocked(const char* logline, int len)
       else if (now - lastFlush_ > flushInterval_)
       {
         lastFlush_ = now;
-        file_->flush();
+        if (file_)
+        {
+          file_->flush();
+        }
       }
     }
     else
@@ -159,7 +358,20 @@ void LogFile::rollFile()
     lastRoll_ = now;
     lastFlush_ = now;
     startOfPeriod_ = start;
-    file_.reset(new File(filename));
+    if (options_ & kUnbuffered)
+    {
+      appendFile_.reset(new AppendFile(filename, options_, rollSize_));
+    }
+    else
+    {
+      file_.reset(new File(filename));
+    }
+    // closed above, the new file is written from now on
+    if (archiver_ && !filename_.empty() && filename_ != filename)
+    {
+      archiver_->archive(filename_, filename);
+    }
+    filename_ = filename;
   }
 }
 
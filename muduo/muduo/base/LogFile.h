@@ -7,23 +7,48 @@
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <sys/uio.h>
+
 namespace muduo
 {
 
+class LogArchiver;
+
 class LogFile : boost::noncopyable
 {
  public:
+  enum Option
+  {
+    kUnbuffered = 1,    // write(2) from the caller's buffer, no stdio copy
+    kPreallocate = 2,   // fallocate(2) rollSize of each file, with kUnbuffered
+    kSyncBehind = 4,    // sync_file_range(2) behind the writer, and drops
+                        // written pages from page cache, with kUnbuffered
+  };
+
   LogFile(const string& basename,
           size_t rollSize,
           bool threadSafe = true,
-          int flushInterval = 3);
+          int flushInterval = 3,
+          int options = 0);
   ~LogFile();
 
   void append(const char* logline, int len);
+  /// One writev(2) for all of them with kUnbuffered.
+  void appendv(const struct iovec* iov, int count);
   void flush();
 
+  /// Gzips rolled files and keeps at most @c maxFiles of them and
+  /// @c maxBytes in all, 0 for no limit, in a background thread.
+  /// Only files of this process count, of any process on this host with
+  /// @c allProcesses, see LogArchiver.  Call before appending.
+  void setArchiving(bool compress, int maxFiles = 0, int64_t maxBytes = 0,
+                    bool allProcesses = false);
+
  private:
   void append_unlocked(const char* logline, int len);
+  void appendv_unlocked(const struct iovec* iov, int count);
+  void rollOrFlush();
+  size_t writtenBytes() const;
 
   static string getLogFileName(const string& basename, time_t* now);
   void rollFile();
@@ -31,8 +56,10 @@ class LogFile : boost::noncopyable
   const string basename_;
   const size_t rollSize_;
   const int flushInterval_;
+  const int options_;
 
   int count_;
+  string filename_;
 
   boost::scoped_ptr<MutexLock> mutex_;
   time_t startOfPeriod_;
@@ -40,6 +67,9 @@ class LogFile : boost::noncopyable
   time_t lastFlush_;
   class File;
   boost::scoped_ptr<File> file_;
+  class AppendFile;
+  boost::scoped_ptr<AppendFile> appendFile_;  // instead of file_, with kUnbuffered
+  boost::scoped_ptr<LogArchiver> archiver_;
 
   const static int kCheckTimeRoll_ = 1024;
   const static int kRollPerSeconds_ = 60*60*24;
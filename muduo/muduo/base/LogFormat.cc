@@ -0,0 +1,380 @@
+#include <muduo/base/LogFormat.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace muduo;
+
+namespace
+{
+
+template<typename V>
+bool put(char** p, const char* end, V v)
+{
+  if (*p + sizeof v > end)
+  {
+    return false;
+  }
+  memcpy(*p, &v, sizeof v);
+  *p += sizeof v;
+  return true;
+}
+
+template<typename V>
+bool get(const char** p, const char* end, V* v)
+{
+  if (*p + sizeof *v > end)
+  {
+    return false;
+  }
+  memcpy(v, *p, sizeof *v);
+  *p += sizeof *v;
+  return true;
+}
+
+template<typename V>
+int formatArg(char* buf, size_t size, const char* spec, int stars, const int* star, V v)
+{
+  int n = 0;
+  if (stars == 0)
+  {
+    n = snprintf(buf, size, spec, v);
+  }
+  else if (stars == 1)
+  {
+    n = snprintf(buf, size, spec, star[0], v);
+  }
+  else
+  {
+    n = snprintf(buf, size, spec, star[0], star[1], v);
+  }
+  if (n < 0)
+  {
+    n = 0;
+  }
+  return n < static_cast<int>(size) ? n : static_cast<int>(size) - 1;
+}
+
+}
+
+LogFormat::LogFormat(int level, const char* file, int line, const char* func, const char* fmt)
+  : level_(level),
+    basename_(file),
+    line_(line),
+    func_(func),
+    fmt_(fmt),
+    eager_(false)
+{
+  const char* slash = strrchr(file, '/');
+  if (slash)
+  {
+    basename_ = slash + 1;
+  }
+
+  Piece piece;
+  const char* p = fmt;
+  while (*p)
+  {
+    if (*p != '%')
+    {
+      piece.literal += *p++;
+    }
+    else if (p[1] == '%')
+    {
+      piece.literal += '%';
+      p += 2;
+    }
+    else
+    {
+      piece.type = parseConversion(&p, &piece);
+      if (piece.type == kNone)
+      {
+        // would get the arguments after it wrong
+        eager_ = true;
+      }
+      pieces_.push_back(piece);
+      piece = Piece();
+    }
+  }
+  if (!piece.literal.empty())
+  {
+    pieces_.push_back(piece);
+  }
+}
+
+LogFormat::ArgType LogFormat::parseConversion(const char** pp, Piece* piece) const
+{
+  const char* start = *pp;
+  const char* p = start + 1;
+  while (*p && strchr("-+ #0'", *p))
+  {
+    ++p;
+  }
+  if (*p == '*')
+  {
+    ++piece->stars;
+    ++p;
+  }
+  while (*p >= '0' && *p <= '9')
+  {
+    ++p;
+  }
+  if (*p == '.')
+  {
+    ++p;
+    piece->precision = 0;
+    if (*p == '*')
+    {
+      ++piece->stars;
+      piece->precision = kStarPrecision;
+      ++p;
+    }
+    while (*p >= '0' && *p <= '9')
+    {
+      piece->precision = piece->precision * 10 + (*p - '0');
+      ++p;
+    }
+  }
+  const char* length = p;
+  while (*p && strchr("hljztLq", *p))
+  {
+    ++p;
+  }
+  string modifier(length, p);
+  const char conversion = *p;
+  if (conversion)
+  {
+    ++p;
+  }
+  piece->spec.assign(start, p);
+  *pp = p;
+
+  ArgType type = kNone;
+  if (conversion && strchr("diouxXc", conversion))
+  {
+    if (modifier.empty() || modifier == "h" || modifier == "hh")
+      type = kInt;
+    else if (modifier == "l" && conversion != 'c')
+      type = kLong;
+    else if (modifier == "ll" || modifier == "q")
+      type = kLongLong;
+    else if (modifier == "z")
+      type = sizeof(size_t) == sizeof(long) ? kLong : kInt;
+    else if (modifier == "t")
+      type = sizeof(ptrdiff_t) == sizeof(long) ? kLong : kInt;
+    else if (modifier == "j")
+      type = sizeof(intmax_t) == sizeof(long) ? kLong : kLongLong;
+  }
+  else if (conversion && strchr("eEfFgGaA", conversion))
+  {
+    if (modifier.empty() || modifier == "l")
+      type = kDouble;
+    else if (modifier == "L")
+      type = kLongDouble;
+  }
+  else if (conversion == 's' && modifier.empty())
+  {
+    type = kString;
+  }
+  else if (conversion == 'p' && modifier.empty())
+  {
+    type = kPointer;
+  }
+  return type;
+}
+
+int LogFormat::encode(char* buf, int avail, va_list args) const
+{
+  if (eager_)
+  {
+    int n = avail > 0 ? vsnprintf(buf, avail, fmt_, args) : 0;
+    if (n < 0)
+    {
+      n = 0;
+    }
+    // without the '\0'
+    return n < avail ? n : avail - 1;
+  }
+
+  char* p = buf;
+  const char* end = buf + avail;
+  bool ok = true;
+  for (size_t i = 0; ok && i < pieces_.size(); ++i)
+  {
+    const Piece& piece = pieces_[i];
+    int star = 0;
+    for (int s = 0; ok && s < piece.stars; ++s)
+    {
+      star = va_arg(args, int);
+      ok = put(&p, end, star);
+    }
+    switch (piece.type)
+    {
+      case kNone:
+        break;
+      case kInt:
+        ok = ok && put(&p, end, va_arg(args, int));
+        break;
+      case kLong:
+        ok = ok && put(&p, end, va_arg(args, long));
+        break;
+      case kLongLong:
+        ok = ok && put(&p, end, va_arg(args, long long));
+        break;
+      case kDouble:
+        ok = ok && put(&p, end, va_arg(args, double));
+        break;
+      case kLongDouble:
+        ok = ok && put(&p, end, va_arg(args, long double));
+        break;
+      case kPointer:
+        ok = ok && put(&p, end, va_arg(args, void*));
+        break;
+      case kString:
+        {
+          const char* str = va_arg(args, const char*);
+          if (str == NULL)
+          {
+            str = "(null)";
+          }
+          int room = static_cast<int>(end - p) - static_cast<int>(sizeof(int));
+          // "%.*s" of a buffer without '\0' must not read past it
+          int precision = piece.precision == kStarPrecision ? star : piece.precision;
+          if (precision >= 0 && precision < room)
+          {
+            room = precision;
+          }
+          int len = ok && room > 0 ? static_cast<int>(strnlen(str, room)) : 0;
+          ok = ok && put(&p, end, len);
+          if (ok)
+          {
+            memcpy(p, str, len);
+            p += len;
+          }
+        }
+        break;
+    }
+  }
+  return static_cast<int>(p - buf);
+}
+
+void LogFormat::decode(const char* buf, int len, LogStream& stream) const
+{
+  if (eager_)
+  {
+    stream.append(buf, len);
+    return;
+  }
+
+  const char* p = buf;
+  const char* end = buf + len;
+  char text[detail::kSmallBuffer];
+  for (size_t i = 0; i < pieces_.size(); ++i)
+  {
+    const Piece& piece = pieces_[i];
+    stream.append(piece.literal.data(), static_cast<int>(piece.literal.size()));
+    int star[2] = { 0, 0 };
+    bool ok = true;
+    for (int s = 0; ok && s < piece.stars; ++s)
+    {
+      ok = get(&p, end, &star[s]);
+    }
+
+    int n = 0;
+    switch (piece.type)
+    {
+      case kNone:
+        break;
+      case kInt:
+        {
+          int v = 0;
+          ok = ok && get(&p, end, &v);
+          // LogStream is faster than snprintf
+          if (ok && piece.spec == "%d")
+          {
+            stream << v;
+          }
+          else if (ok)
+          {
+            n = formatArg(text, sizeof text, piece.spec.c_str(), piece.stars, star, v);
+          }
+        }
+        break;
+      case kLong:
+        {
+          long v = 0;
+          ok = ok && get(&p, end, &v);
+          if (ok && piece.spec == "%ld")
+          {
+            stream << v;
+          }
+          else if (ok)
+          {
+            n = formatArg(text, sizeof text, piece.spec.c_str(), piece.stars, star, v);
+          }
+        }
+        break;
+      case kLongLong:
+        {
+          long long v = 0;
+          ok = ok && get(&p, end, &v);
+          if (ok && piece.spec == "%lld")
+          {
+            stream << v;
+          }
+          else if (ok)
+          {
+            n = formatArg(text, sizeof text, piece.spec.c_str(), piece.stars, star, v);
+          }
+        }
+        break;
+      case kDouble:
+        {
+          double v = 0;
+          ok = ok && get(&p, end, &v);
+          n = ok ? formatArg(text, sizeof text, piece.spec.c_str(), piece.stars, star, v) : 0;
+        }
+        break;
+      case kLongDouble:
+        {
+          long double v = 0;
+          ok = ok && get(&p, end, &v);
+          n = ok ? formatArg(text, sizeof text, piece.spec.c_str(), piece.stars, star, v) : 0;
+        }
+        break;
+      case kPointer:
+        {
+          void* v = NULL;
+          ok = ok && get(&p, end, &v);
+          n = ok ? formatArg(text, sizeof text, piece.spec.c_str(), piece.stars, star, v) : 0;
+        }
+        break;
+      case kString:
+        {
+          int size = 0;
+          ok = ok && get(&p, end, &size) && size >= 0 && p + size <= end;
+          if (ok)
+          {
+            if (piece.spec == "%s")
+            {
+              stream.append(p, size);
+            }
+            else
+            {
+              string str(p, size);
+              n = formatArg(text, sizeof text, piece.spec.c_str(), piece.stars, star, str.c_str());
+            }
+            p += size;
+          }
+        }
+        break;
+    }
+    if (!ok)
+    {
+      // truncated by encode()
+      break;
+    }
+    stream.append(text, n);
+  }
+}
@@ -0,0 +1,82 @@
+#ifndef MUDUO_BASE_LOGFORMAT_H
+#define MUDUO_BASE_LOGFORMAT_H
+
+#include <muduo/base/LogStream.h>
+#include <muduo/base/Types.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include <stdarg.h>
+
+namespace muduo
+{
+
+///
+/// The printf format of a LOG_*F call site, parsed once.
+///
+/// Arguments are copied as raw bytes by encode(), and turned into text by
+/// decode() later, usually in the AsyncLogging thread.  Lives as a static
+/// in its call site, records refer to it by address.
+class LogFormat : boost::noncopyable
+{
+ public:
+  /// A conversion it can't record, eg. %m or %ls, makes encode() format
+  /// the whole message at once, in the calling thread.
+  LogFormat(int level, const char* file, int line, const char* func, const char* fmt);
+
+  int level() const { return level_; }
+  const char* basename() const { return basename_; }
+  int line() const { return line_; }
+  const char* func() const { return func_; }
+  const char* format() const { return fmt_; }
+  bool eager() const { return eager_; }
+
+  /// Copies arguments into @c buf, strings are truncated to fit.
+  /// @return bytes used
+  int encode(char* buf, int avail, va_list args) const;
+
+  /// Appends the message of what encode() recorded.
+  void decode(const char* buf, int len, LogStream& stream) const;
+
+ private:
+  enum ArgType
+  {
+    kNone,        // literal text only
+    kInt,         // char, short and int are promoted to it
+    kLong,
+    kLongLong,
+    kDouble,
+    kLongDouble,
+    kString,
+    kPointer,
+  };
+
+  static const int kNoPrecision = -1;
+  static const int kStarPrecision = -2;  // the last '*' argument
+
+  // literal text, then one conversion
+  struct Piece
+  {
+    Piece() : type(kNone), stars(0), precision(kNoPrecision) { }
+    string literal;
+    string spec;
+    ArgType type;
+    int stars;      // '*' width or precision, an int argument each
+    int precision;  // bounds the bytes read of a string
+  };
+
+  ArgType parseConversion(const char** p, Piece* piece) const;
+
+  const int level_;
+  const char* basename_;
+  const int line_;
+  const char* func_;
+  const char* fmt_;
+  bool eager_;  // the record holds the text, not arguments
+  std::vector<Piece> pieces_;
+};
+
+}
+#endif  // MUDUO_BASE_LOGFORMAT_H
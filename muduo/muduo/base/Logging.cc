@@ -5,6 +5,7 @@
 #include <muduo/base/Timestamp.h>
 
 #include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -33,6 +34,8 @@ class LoggerImpl
 __thread char t_errnobuf[512];
 __thread char t_time[32];
 __thread time_t t_lastSecond;
+__thread char t_recordTid[32];  // of records formatted in this thread
+__thread int t_lastRecordTid;
 
 const char* strerror_tl(int savedErrno)
 {
@@ -103,6 +106,43 @@ void defaultFlush()
 Logger::OutputFunc g_output = defaultOutput;
 Logger::FlushFunc g_flush = defaultFlush;
 
+void defaultRecordOutput(const char* record, int len)
+{
+  LogStream stream;
+  Logger::formatRecord(record, len, stream);
+  g_output(stream.buffer().data(), stream.buffer().length());
+}
+
+Logger::RecordOutputFunc g_recordOutput = defaultRecordOutput;
+
+// precedes the arguments in a record of Logger::logf()
+struct RecordHeader
+{
+  const LogFormat* format;
+  int64_t microSecondsSinceEpoch;
+  int tid;
+};
+
+void formatTime(LogStream& stream, int64_t microSecondsSinceEpoch)
+{
+  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / 1000000);
+  int microseconds = static_cast<int>(microSecondsSinceEpoch % 1000000);
+  if (seconds != t_lastSecond)
+  {
+    t_lastSecond = seconds;
+    struct tm tm_time;
+    ::gmtime_r(&seconds, &tm_time); // FIXME TimeZone::fromUtcTime
+
+    int len = snprintf(t_time, sizeof(t_time), "%4d%02d%02d %02d:%02d:%02d",
+        tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+        tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+    assert(len == 17); (void)len;
+  }
+  Fmt us(".%06dZ ", microseconds);
+  assert(us.length() == 9);
+  stream << T(t_time, 17) << T(us.data(), 9);
+}
+
 }
 
 using namespace muduo;
@@ -126,23 +166,7 @@ Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int l
 
 void Logger::Impl::formatTime()
 {
-  int64_t microSecondsSinceEpoch = time_.microSecondsSinceEpoch();
-  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / 1000000);
-  int microseconds = static_cast<int>(microSecondsSinceEpoch % 1000000);
-  if (seconds != t_lastSecond)
-  {
-    t_lastSecond = seconds;
-    struct tm tm_time;
-    ::gmtime_r(&seconds, &tm_time); // FIXME TimeZone::fromUtcTime
-
-    int len = snprintf(t_time, sizeof(t_time), "%4d%02d%02d %02d:%02d:%02d",
-        tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-        tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
-    assert(len == 17); (void)len;
-  }
-  Fmt us(".%06dZ ", microseconds);
-  assert(us.length() == 9);
-  stream_ << T(t_time, 17) << T(us.data(), 9);
+  muduo::formatTime(stream_, time_.microSecondsSinceEpoch());
 }
 
 void Logger::Impl::finish()
@@ -197,3 +221,57 @@ void Logger::setFlush(FlushFunc flush)
 {
   g_flush = flush;
 }
+
+void Logger::setRecordOutput(RecordOutputFunc out)
+{
+  g_recordOutput = out;
+}
+
+void Logger::checkFormat(const char*, ...)
+{
+}
+
+void Logger::logf(const LogFormat* format, ...)
+{
+  // for %m of an eager format
+  int savedErrno = errno;
+  char record[detail::kSmallBuffer];
+  RecordHeader header = { format,
+                          Timestamp::now().microSecondsSinceEpoch(),
+                          CurrentThread::tid() };
+  memcpy(record, &header, sizeof header);
+  errno = savedErrno;
+  va_list args;
+  va_start(args, format);
+  int len = format->encode(record + sizeof header,
+                           static_cast<int>(sizeof record - sizeof header),
+                           args);
+  va_end(args);
+  g_recordOutput(record, static_cast<int>(sizeof header) + len);
+}
+
+void Logger::formatRecord(const char* record, int len, LogStream& stream)
+{
+  RecordHeader header;
+  assert(len >= static_cast<int>(sizeof header));
+  memcpy(&header, record, sizeof header);
+  const LogFormat* format = header.format;
+  LogLevel level = static_cast<LogLevel>(format->level());
+
+  formatTime(stream, header.microSecondsSinceEpoch);
+  if (header.tid != t_lastRecordTid)
+  {
+    t_lastRecordTid = header.tid;
+    snprintf(t_recordTid, sizeof t_recordTid, "%5d ", header.tid);
+  }
+  stream << T(t_recordTid, 6);
+  stream << T(LogLevelName[level], 6);
+  if (level <= DEBUG)
+  {
+    stream << format->func() << ' ';
+  }
+  format->decode(record + sizeof header,
+                 len - static_cast<int>(sizeof header),
+                 stream);
+  stream << " - " << format->basename() << ':' << format->line() << '\n';
+}
@@ -1,6 +1,7 @@
 #ifndef MUDUO_BASE_LOGGING_H
 #define MUDUO_BASE_LOGGING_H
 
+#include <muduo/base/LogFormat.h>
 #include <muduo/base/LogStream.h>
 #include <muduo/base/Timestamp.h>
 
@@ -69,6 +70,18 @@ class Logger
   static void setOutput(OutputFunc);
   static void setFlush(FlushFunc);
 
+  /// Deferred formatting, used by LOG_*F.  Records the arguments of
+  /// @c format, the time and the thread, hands them to RecordOutputFunc.
+  static void logf(const LogFormat* format, ...);
+  static void checkFormat(const char* fmt, ...) __attribute__ ((format (printf, 1, 2)));
+  /// Appends the log line of a record made by logf(), in any thread.
+  static void formatRecord(const char* record, int len, LogStream& stream);
+
+  /// Defaults to formatting the record and calling OutputFunc at once,
+  /// AsyncLogging::appendRecord() defers it to its thread.
+  typedef void (*RecordOutputFunc)(const char* record, int len);
+  static void setRecordOutput(RecordOutputFunc);
+
  private:
 
 class Impl
@@ -91,6 +104,7 @@ class Impl
 };
 
 extern Logger::LogLevel g_logLevel;
+extern const char* LogLevelName[Logger::NUM_LOG_LEVELS];
 
 inline Logger::LogLevel Logger::logLevel()
 {
@@ -109,6 +123,22 @@ inline Logger::LogLevel Logger::logLevel()
 #define LOG_SYSERR muduo::Logger(__FILE__, __LINE__, false).stream()
 #define LOG_SYSFATAL muduo::Logger(__FILE__, __LINE__, true).stream()
 
+// printf style, formatted later, see Logger::logf()
+#define LOG_FORMAT_(level, fmt, ...) do { \
+  static const muduo::LogFormat muduo_log_format_(level, __FILE__, __LINE__, __func__, fmt); \
+  if (false) muduo::Logger::checkFormat(fmt, ##__VA_ARGS__); \
+  muduo::Logger::logf(&muduo_log_format_, ##__VA_ARGS__); \
+} while (0)
+
+#define LOG_TRACEF(fmt, ...) if (muduo::Logger::logLevel() <= muduo::Logger::TRACE) \
+  LOG_FORMAT_(muduo::Logger::TRACE, fmt, ##__VA_ARGS__)
+#define LOG_DEBUGF(fmt, ...) if (muduo::Logger::logLevel() <= muduo::Logger::DEBUG) \
+  LOG_FORMAT_(muduo::Logger::DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFOF(fmt, ...) if (muduo::Logger::logLevel() <= muduo::Logger::INFO) \
+  LOG_FORMAT_(muduo::Logger::INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARNF(fmt, ...) LOG_FORMAT_(muduo::Logger::WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERRORF(fmt, ...) LOG_FORMAT_(muduo::Logger::ERROR, fmt, ##__VA_ARGS__)
+
 const char* strerror_tl(int savedErrno);
 
 // Taken from glog/logging.h
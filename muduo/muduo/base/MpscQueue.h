@@ -0,0 +1,145 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_MPSCQUEUE_H
+#define MUDUO_BASE_MPSCQUEUE_H
+
+#include <boost/noncopyable.hpp>
+#include <stddef.h>
+
+namespace muduo
+{
+
+///
+/// Lock-free multi-producer single-consumer queue.
+///
+/// Producers push onto a linked stack with CAS, each put() allocates
+/// a node for a copy of the element.  The consumer detaches the whole
+/// stack with one CAS and reverses it, so elements are taken in FIFO
+/// order, in batches.
+///
+template<typename T>
+class MpscQueue : boost::noncopyable
+{
+ public:
+  MpscQueue()
+    : head_(NULL)
+  {
+  }
+
+  ~MpscQueue()
+  {
+    Chain leftover(detach());
+  }
+
+  /// Safe to call from any thread.
+  void put(const T& x)
+  {
+    Node* node = new Node(x);
+    Node* head = head_;
+    for (;;)
+    {
+      node->next = head;
+      // full barrier, node is constructed before it is published
+      Node* seen = __sync_val_compare_and_swap(&head_, head, node);
+      if (seen == head)
+        break;
+      head = seen;
+    }
+  }
+
+  /// Calls f(x) for every element put so far, in FIFO order.
+  /// Elements put meanwhile, even by f, are left for next time.
+  /// If f throws, the rest of the batch is dropped.
+  /// Must be called by the only consumer.
+  /// @return number of elements taken
+  template<typename F>
+  size_t takeAll(F f)
+  {
+    Node* node = detach();
+    // reverse to FIFO order
+    Node* fifo = NULL;
+    while (node)
+    {
+      Node* next = node->next;
+      node->next = fifo;
+      fifo = node;
+      node = next;
+    }
+
+    Chain batch(fifo);
+    size_t n = 0;
+    while (batch.head)
+    {
+      f(batch.head->value);
+      Node* next = batch.head->next;
+      delete batch.head;
+      batch.head = next;
+      ++n;
+    }
+    return n;
+  }
+
+  /// Not accurate when producers are putting.
+  bool empty() const
+  {
+    return head_ == NULL;
+  }
+
+ private:
+  struct Node
+  {
+    explicit Node(const T& x)
+      : value(x),
+        next(NULL)
+    {
+    }
+
+    T value;
+    Node* next;
+  };
+
+  // deletes the nodes it still holds
+  struct Chain : boost::noncopyable
+  {
+    explicit Chain(Node* node)
+      : head(node)
+    {
+    }
+
+    ~Chain()
+    {
+      while (head)
+      {
+        Node* next = head->next;
+        delete head;
+        head = next;
+      }
+    }
+
+    Node* head;
+  };
+
+  Node* detach()
+  {
+    Node* head = head_;
+    for (;;)
+    {
+      Node* seen = __sync_val_compare_and_swap(&head_, head, static_cast<Node*>(NULL));
+      if (seen == head)
+        return head;
+      head = seen;
+    }
+  }
+
+  Node* volatile head_;  // most recently put
+};
+
+}
+
+#endif  // MUDUO_BASE_MPSCQUEUE_H
@@ -0,0 +1,122 @@
+// Logs from several threads at once, compares per-thread staging with
+// the shared buffers, and LOG_INFOF with LOG_INFO.  Every 100th line is
+// a WARN, to see what OverloadPolicy keeps when the disk can't keep up.
+//
+// Usage: asynclogging_bench [threads=4] [lines=1000000] [staging=1] [deferred=0]
+//                           [drop|block|keepwarn|sample] [max_buffers=25]
+
+#include <muduo/base/AsyncLogging.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+muduo::AsyncLogging* g_asyncLog = NULL;
+
+void asyncOutput(const char* msg, int len)
+{
+  g_asyncLog->append(msg, len);
+}
+
+void asyncRecordOutput(const char* record, int len)
+{
+  g_asyncLog->appendRecord(record, len);
+}
+
+void threadFunc(muduo::CountDownLatch* latch, int lines, bool deferred)
+{
+  latch->wait();
+  if (deferred)
+  {
+    for (int i = 0; i < lines; ++i)
+    {
+      if (i % 100 == 0)
+        LOG_WARNF("Hello 0123456789 abcdefghijklmnopqrstuvwxyz %d", i);
+      else
+        LOG_INFOF("Hello 0123456789 abcdefghijklmnopqrstuvwxyz %d", i);
+    }
+  }
+  else
+  {
+    for (int i = 0; i < lines; ++i)
+    {
+      if (i % 100 == 0)
+        LOG_WARN << "Hello 0123456789" << " abcdefghijklmnopqrstuvwxyz " << i;
+      else
+        LOG_INFO << "Hello 0123456789" << " abcdefghijklmnopqrstuvwxyz " << i;
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const int numThreads = argc > 1 ? atoi(argv[1]) : 4;
+  const int lines = argc > 2 ? atoi(argv[2]) : 1000000;
+  const bool staging = argc > 3 ? atoi(argv[3]) != 0 : true;
+  const bool deferred = argc > 4 ? atoi(argv[4]) != 0 : false;
+  const char* policyName = argc > 5 ? argv[5] : "drop";
+  const int maxBuffers = argc > 6 ? atoi(argv[6]) : muduo::AsyncLogging::kDefaultMaxBuffers;
+  muduo::AsyncLogging::OverloadPolicy policy = muduo::AsyncLogging::kDropNew;
+  if (strcmp(policyName, "block") == 0)
+    policy = muduo::AsyncLogging::kBlock;
+  else if (strcmp(policyName, "keepwarn") == 0)
+    policy = muduo::AsyncLogging::kKeepWarn;
+  else if (strcmp(policyName, "sample") == 0)
+    policy = muduo::AsyncLogging::kSample;
+
+  muduo::AsyncLogging log("asynclogging_bench", 500*1000*1000);
+  log.setThreadStaging(staging);
+  log.setOverloadPolicy(policy, maxBuffers);
+  log.start();
+  g_asyncLog = &log;
+  muduo::Logger::setOutput(asyncOutput);
+  muduo::Logger::setRecordOutput(asyncRecordOutput);
+
+  muduo::CountDownLatch latch(1);
+  boost::ptr_vector<muduo::Thread> threads;
+  for (int i = 0; i < numThreads; ++i)
+  {
+    threads.push_back(new muduo::Thread(boost::bind(threadFunc, &latch, lines, deferred)));
+    threads.back().start();
+  }
+
+  muduo::Timestamp start(muduo::Timestamp::now());
+  latch.countDown();
+  for (int i = 0; i < numThreads; ++i)
+  {
+    threads[i].join();
+  }
+  muduo::Timestamp logged(muduo::Timestamp::now());
+  log.stop();
+  muduo::Timestamp written(muduo::Timestamp::now());
+
+  const double total = static_cast<double>(numThreads) * lines;
+  printf("%s%s: %d threads, %.0f lines in %.3f seconds, %.0f lines/s, "
+         "%.0f ns per line, written after %.3f seconds\n",
+         staging ? "staging" : "shared", deferred ? " deferred" : "", numThreads, total,
+         timeDifference(logged, start), total / timeDifference(logged, start),
+         timeDifference(logged, start) * numThreads * 1e9 / total,
+         timeDifference(written, start));
+
+  muduo::AsyncLogging::OverloadStats stats = log.overloadStats();
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("%s, max buffers %d: dropped %lld INFO, %lld WARN, %lld bytes, "
+         "blocked %lld times, %lld us, max RSS %ld KiB\n",
+         policyName, maxBuffers,
+         static_cast<long long>(stats.droppedLines[muduo::Logger::INFO]),
+         static_cast<long long>(stats.droppedLines[muduo::Logger::WARN]),
+         static_cast<long long>(stats.droppedBytes[muduo::Logger::INFO]
+                                + stats.droppedBytes[muduo::Logger::WARN]),
+         static_cast<long long>(stats.blocked),
+         static_cast<long long>(stats.blockedMicros),
+         usage.ru_maxrss);
+}
@@ -0,0 +1,90 @@
+// Writes 4 MB buffers of log lines to LogFile the way AsyncLogging does,
+// compares stdio with the unbuffered options.  With archive, rolled files
+// are gzipped meanwhile, the slowest write shows if the writer waits.
+//
+// Usage: logfile_bench [stdio|unbuffered|prealloc|sync|archive] [total_mb=2048]
+//                      [buffers=2] [roll_mb=1024]
+
+#include <muduo/base/LogFile.h>
+#include <muduo/base/Timestamp.h>
+
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+double toSeconds(const struct timeval& tv)
+{
+  return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* mode = argc > 1 ? argv[1] : "stdio";
+  const int totalMB = argc > 2 ? atoi(argv[2]) : 2048;
+  const int numBuffers = argc > 3 ? atoi(argv[3]) : 2;
+  const int rollMB = argc > 4 ? atoi(argv[4]) : 1024;
+  const bool archive = strcmp(mode, "archive") == 0;
+  int options = 0;
+  if (strcmp(mode, "unbuffered") == 0)
+    options = muduo::LogFile::kUnbuffered;
+  else if (strcmp(mode, "prealloc") == 0)
+    options = muduo::LogFile::kUnbuffered | muduo::LogFile::kPreallocate;
+  else if (archive)
+    options = muduo::LogFile::kUnbuffered;
+  else if (strcmp(mode, "sync") == 0)
+    options = muduo::LogFile::kUnbuffered | muduo::LogFile::kPreallocate
+              | muduo::LogFile::kSyncBehind;
+
+  const size_t kBufferSize = 4000*1000;
+  std::vector<char> buffer;
+  buffer.reserve(kBufferSize);
+  const char* line = "20130510 03:27:30.123456Z  1234 INFO  Hello 0123456789 "
+                     "abcdefghijklmnopqrstuvwxyz 12345 - LogFile_bench.cc:42\n";
+  while (buffer.size() + strlen(line) <= kBufferSize)
+  {
+    buffer.insert(buffer.end(), line, line + strlen(line));
+  }
+
+  std::vector<struct iovec> iov(numBuffers);
+  for (int i = 0; i < numBuffers; ++i)
+  {
+    iov[i].iov_base = &*buffer.begin();
+    iov[i].iov_len = buffer.size();
+  }
+
+  const int64_t total = static_cast<int64_t>(totalMB) * 1024 * 1024;
+  int64_t written = 0;
+  int64_t maxCallMicros = 0;
+  muduo::Timestamp start(muduo::Timestamp::now());
+  {
+    muduo::LogFile output("logfile_bench", static_cast<size_t>(rollMB)*1024*1024,
+                          false, 3, options);
+    if (archive)
+    {
+      output.setArchiving(true);
+    }
+    while (written < total)
+    {
+      muduo::Timestamp before(muduo::Timestamp::now());
+      output.appendv(&*iov.begin(), numBuffers);
+      output.flush();
+      int64_t micros = muduo::Timestamp::now().microSecondsSinceEpoch()
+                       - before.microSecondsSinceEpoch();
+      maxCallMicros = std::max(maxCallMicros, micros);
+      written += static_cast<int64_t>(buffer.size()) * numBuffers;
+    }
+  }
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("%s: %lld MiB in %.3f seconds, %.1f MiB/s, slowest write %lld us, "
+         "user %.3f s, sys %.3f s\n",
+         mode, static_cast<long long>(written / 1024 / 1024), seconds,
+         static_cast<double>(written) / 1024 / 1024 / seconds,
+         static_cast<long long>(maxCallMicros),
+         toSeconds(usage.ru_utime), toSeconds(usage.ru_stime));
+}
@@ -2,6 +2,7 @@
 #include <muduo/base/LogFile.h>
 #include <muduo/base/ThreadPool.h>
 
+#include <errno.h>
 #include <stdio.h>
 
 int g_total;
@@ -21,7 +22,12 @@ void dummyOutput(const char* msg, int len)
   }
 }
 
-void bench(const char* type)
+void dummyRecordOutput(const char* record, int len)
+{
+  g_total += len;
+}
+
+void bench(const char* type, bool deferred = false)
 {
   muduo::Logger::setOutput(dummyOutput);
   muduo::Timestamp start(muduo::Timestamp::now());
@@ -32,11 +38,24 @@ void bench(const char* type)
   muduo::string empty = " ";
   muduo::string longStr(3000, 'X');
   longStr += " ";
-  for (int i = 0; i < n; ++i)
+  if (deferred)
   {
-    LOG_INFO << "Hello 0123456789" << " abcdefghijklmnopqrstuvwxyz"
-             << (kLongLog ? longStr : empty)
-             << i;
+    // formatting is left to whoever takes the records
+    muduo::Logger::setRecordOutput(dummyRecordOutput);
+    for (int i = 0; i < n; ++i)
+    {
+      LOG_INFOF("Hello 0123456789 abcdefghijklmnopqrstuvwxyz%s%d",
+                (kLongLog ? longStr : empty).c_str(), i);
+    }
+  }
+  else
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      LOG_INFO << "Hello 0123456789" << " abcdefghijklmnopqrstuvwxyz"
+               << (kLongLog ? longStr : empty)
+               << i;
+    }
   }
   muduo::Timestamp end(muduo::Timestamp::now());
   double seconds = timeDifference(end, start);
@@ -72,8 +91,21 @@ int main()
   LOG_INFO << sizeof(muduo::Fmt);
   LOG_INFO << sizeof(muduo::LogStream::Buffer);
 
+  LOG_TRACEF("trace %d", 1);
+  LOG_DEBUGF("debug %s", "two");
+  LOG_INFOF("Hello %s, %5.2f %-4d| %*d %.*s %lld %zu %c %% %x", "World", 3.14159, 42,
+            6, -1, 3, "abcdef", 1LL << 40, sizeof(muduo::LogFormat), 'z', 255u);
+  const char noNul[4] = { 'a', 'b', 'c', 'd' };  // eg. Buffer::peek()
+  LOG_INFOF("precision bounds strings %.3s|%.*s|", noNul, 4, noNul);
+  LOG_WARNF("World %p", static_cast<void*>(&g_total));
+  LOG_ERRORF("Error");
+  // can't be recorded, formatted at once
+  errno = ENOENT;
+  LOG_ERRORF("Error %m %ls %Lg", L"wide", 1.5L);
+
   sleep(1);
   bench("nop");
+  bench("nop deferred", true);
 
   char buffer[64*1024];
 
@@ -0,0 +1,127 @@
+#include <muduo/base/MpscQueue.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <vector>
+#include <assert.h>
+#include <stdio.h>
+
+const int kThreads = 4;
+const int kTimes = 100000;
+
+struct Item
+{
+  int thread;
+  int seq;
+};
+
+int g_live = 0;
+
+struct Counted
+{
+  Counted() { ++g_live; }
+  Counted(const Counted&) { ++g_live; }
+  ~Counted() { --g_live; }
+};
+
+void throwOnFirst(const Counted&)
+{
+  throw 1;
+}
+
+class Test
+{
+ public:
+  Test()
+    : latch_(kThreads),
+      threads_(kThreads),
+      next_(kThreads),
+      taken_(0)
+  {
+    for (int i = 0; i < kThreads; ++i)
+    {
+      char name[32];
+      snprintf(name, sizeof name, "put thread %d", i);
+      threads_.push_back(new muduo::Thread(
+            boost::bind(&Test::threadFunc, this, i), muduo::string(name)));
+    }
+    for_each(threads_.begin(), threads_.end(), boost::bind(&muduo::Thread::start, _1));
+  }
+
+  void run()
+  {
+    latch_.wait();
+    size_t batches = 0;
+    while (taken_ < kThreads * kTimes)
+    {
+      if (queue_.takeAll(boost::bind(&Test::check, this, _1)) > 0)
+      {
+        ++batches;
+      }
+    }
+    assert(queue_.empty());
+    for_each(threads_.begin(), threads_.end(), boost::bind(&muduo::Thread::join, _1));
+    printf("taken %d items in %zd batches\n", taken_, batches);
+  }
+
+ private:
+  void threadFunc(int thread)
+  {
+    latch_.countDown();
+    for (int i = 0; i < kTimes; ++i)
+    {
+      Item item = { thread, i };
+      queue_.put(item);
+    }
+  }
+
+  void check(const Item& item)
+  {
+    // FIFO for each producer
+    assert(item.seq == next_[item.thread]);
+    ++next_[item.thread];
+    ++taken_;
+  }
+
+  muduo::MpscQueue<Item> queue_;
+  muduo::CountDownLatch latch_;
+  boost::ptr_vector<muduo::Thread> threads_;
+  std::vector<int> next_;
+  int taken_;
+};
+
+int main()
+{
+  Test t;
+  t.run();
+
+  {
+  // leftovers are freed by dtor
+  muduo::MpscQueue<muduo::string> queue;
+  queue.put("hello");
+  queue.put("world");
+  assert(!queue.empty());
+  }
+
+  {
+  // the rest of the batch is freed if a functor throws
+  muduo::MpscQueue<Counted> queue;
+  queue.put(Counted());
+  queue.put(Counted());
+  queue.put(Counted());
+  assert(g_live == 3);
+  try
+  {
+    queue.takeAll(throwOnFirst);
+    assert(false);
+  }
+  catch (int)
+  {
+  }
+  assert(g_live == 0);
+  assert(queue.empty());
+  }
+  printf("done\n");
+}
@@ -8,6 +8,7 @@
 
 #include <muduo/net/Acceptor.h>
 
+#include <muduo/base/Logging.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/InetAddress.h>
 #include <muduo/net/SocketsOps.h>
@@ -16,22 +17,63 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <unistd.h>
 //#include <sys/types.h>
-//#include <sys/stat.h>
+#include <sys/stat.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
-Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr)
+namespace
+{
+
+// a socket file nobody listens on, eg. left by a crashed run
+bool isStaleSocket(const InetAddress& addr)
+{
+  struct stat st;
+  if (::lstat(addr.toIp().c_str(), &st) < 0 || !S_ISSOCK(st.st_mode))
+  {
+    return false;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+  bool stale = ::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0
+               && errno == ECONNREFUSED;
+  ::close(fd);
+  return stale;
+}
+
+}
+
+Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
   : loop_(loop),
-    acceptSocket_(sockets::createNonblockingOrDie()),
+    acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),
     acceptChannel_(loop, acceptSocket_.fd()),
+    maxAcceptsPerRead_(1),
     listenning_(false),
-    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),
+    unixInode_(0)
 {
   assert(idleFd_ >= 0);
   acceptSocket_.setReuseAddr(true);
+  acceptSocket_.setReusePort(reuseport);
+  if (listenAddr.family() == AF_UNIX && isStaleSocket(listenAddr))
+  {
+    // left by an earlier run, bind(2) fails with EADDRINUSE otherwise.
+    // A live server's socket or another file is kept, bind(2) fails.
+    LOG_INFO << "Acceptor - removes stale socket " << listenAddr.toIp();
+    ::unlink(listenAddr.toIp().c_str());
+  }
   acceptSocket_.bindAddress(listenAddr);
+  struct stat st;
+  if (listenAddr.family() == AF_UNIX && ::stat(listenAddr.toIp().c_str(), &st) == 0)
+  {
+    unixPath_ = listenAddr.toIp();
+    unixInode_ = st.st_ino;
+  }
   acceptChannel_.setReadCallback(
       boost::bind(&Acceptor::handleRead, this));
 }
@@ -41,6 +83,13 @@ Acceptor::~Acceptor()
   acceptChannel_.disableAll();
   acceptChannel_.remove();
   ::close(idleFd_);
+  struct stat st;
+  // unless replaced by someone else meanwhile
+  if (!unixPath_.empty()
+      && ::stat(unixPath_.c_str(), &st) == 0 && st.st_ino == unixInode_)
+  {
+    ::unlink(unixPath_.c_str());
+  }
 }
 
 void Acceptor::listen()
@@ -54,34 +103,45 @@ void Acceptor::listen()
 void Acceptor::handleRead()
 {
   loop_->assertInLoopThread();
-  InetAddress peerAddr(0);
-  //FIXME loop until no more
-  int connfd = acceptSocket_.accept(&peerAddr);
-  if (connfd >= 0)
+  assert(maxAcceptsPerRead_ > 0);
+  int accepted = 0;
+  while (accepted < maxAcceptsPerRead_)
   {
-    // string hostport = peerAddr.toIpPort();
-    // LOG_TRACE << "Accepts of " << hostport;
-    if (newConnectionCallback_)
+    InetAddress peerAddr(0);
+    int connfd = acceptSocket_.accept(&peerAddr);
+    if (connfd >= 0)
     {
-      newConnectionCallback_(connfd, peerAddr);
+      ++accepted;
+      // string hostport = peerAddr.toIpPort();
+      // LOG_TRACE << "Accepts of " << hostport;
+      if (newConnectionCallback_)
+      {
+        newConnectionCallback_(connfd, peerAddr);
+      }
+      else
+      {
+        sockets::close(connfd);
+      }
     }
     else
     {
-      sockets::close(connfd);
+      // Read the section named "The special problem of
+      // accept()ing when you can't" in libev's doc.
+      // By Marc Lehmann, author of livev.
+      if (errno == EMFILE)
+      {
+        ::close(idleFd_);
+        idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
+        ::close(idleFd_);
+        idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+      }
+      break;
     }
   }
-  else
+
+  if (accepted > 0 && acceptBatchCallback_)
   {
-    // Read the section named "The special problem of
-    // accept()ing when you can't" in libev's doc.
-    // By Marc Lehmann, author of livev.
-    if (errno == EMFILE)
-    {
-      ::close(idleFd_);
-      idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
-      ::close(idleFd_);
-      idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
-    }
+    acceptBatchCallback_();
   }
 }
 
@@ -14,9 +14,12 @@
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <muduo/base/Types.h>
 #include <muduo/net/Channel.h>
 #include <muduo/net/Socket.h>
 
+#include <sys/types.h>
+
 namespace muduo
 {
 namespace net
@@ -33,13 +36,26 @@ class Acceptor : boost::noncopyable
  public:
   typedef boost::function<void (int sockfd,
                                 const InetAddress&)> NewConnectionCallback;
+  typedef boost::function<void ()> AcceptBatchCallback;
 
-  Acceptor(EventLoop* loop, const InetAddress& listenAddr);
+  /// With @c reuseport, several Acceptors may listen on the same address,
+  /// the kernel balances incoming connections among them.
+  Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport = false);
   ~Acceptor();
 
   void setNewConnectionCallback(const NewConnectionCallback& cb)
   { newConnectionCallback_ = cb; }
 
+  /// Called after the last connection accepted in one readiness event.
+  void setAcceptBatchCallback(const AcceptBatchCallback& cb)
+  { acceptBatchCallback_ = cb; }
+
+  /// Accepts until EAGAIN or @c maxAccepts connections per readiness event,
+  /// default is 1, which leaves the rest to next poll.
+  void setMaxAcceptsPerRead(int maxAccepts)
+  { maxAcceptsPerRead_ = maxAccepts; }
+
+  EventLoop* getLoop() const { return loop_; }
   bool listenning() const { return listenning_; }
   void listen();
 
@@ -50,8 +66,12 @@ class Acceptor : boost::noncopyable
   Socket acceptSocket_;
   Channel acceptChannel_;
   NewConnectionCallback newConnectionCallback_;
+  AcceptBatchCallback acceptBatchCallback_;
+  int maxAcceptsPerRead_;
   bool listenning_;
   int idleFd_;
+  string unixPath_;  // bound by this one, removed when done
+  ino_t unixInode_;
 };
 
 }
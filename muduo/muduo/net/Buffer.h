@@ -45,13 +45,13 @@ class Buffer : public muduo::copyable
   static const size_t kCheapPrepend = 8;
   static const size_t kInitialSize = 1024;
 
-  Buffer()
-    : buffer_(kCheapPrepend + kInitialSize),
+  explicit Buffer(size_t initialSize = kInitialSize)
+    : buffer_(kCheapPrepend + initialSize),
       readerIndex_(kCheapPrepend),
       writerIndex_(kCheapPrepend)
   {
     assert(readableBytes() == 0);
-    assert(writableBytes() == kInitialSize);
+    assert(writableBytes() == initialSize);
     assert(prependableBytes() == kCheapPrepend);
   }
 
@@ -296,6 +296,11 @@ class Buffer : public muduo::copyable
     swap(other);
   }
 
+  size_t internalCapacity() const
+  {
+    return buffer_.capacity();
+  }
+
   /// Read data directly into buffer.
   ///
   /// It may implement with readv(2)
@@ -0,0 +1,208 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include <muduo/net/BufferChain.h>
+
+#include <muduo/net/Buffer.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <sys/uio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t BufferChain::kBlockSize;
+const size_t BufferChain::kCopyThreshold;
+const int BufferChain::kMaxIovecs;
+
+void BufferChain::append(const char* data, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+
+  if (tail_ == NULL || tail_->writableBytes() < len)
+  {
+    // start a new block, never grow the old one
+    boost::shared_ptr<Buffer> block(new Buffer);
+    block->ensureWritableBytes(std::max(len, kBlockSize));
+    Slice slice;
+    slice.holder = block;
+    slice.data = block->peek();
+    slice.len = 0;
+    slices_.push_back(slice);
+    tail_ = get_pointer(block);
+  }
+  assert(slices_.back().data + slices_.back().len == tail_->beginWrite());
+  tail_->append(data, len);
+  slices_.back().len += len;
+  readableBytes_ += len;
+}
+
+void BufferChain::append(Buffer* buf)
+{
+  size_t len = buf->readableBytes();
+  if (len < kCopyThreshold)
+  {
+    append(buf->peek(), len);
+    buf->retrieveAll();
+  }
+  else
+  {
+    boost::shared_ptr<Buffer> block(new Buffer);
+    block->swap(*buf);
+    append(block, block->peek(), len);
+  }
+}
+
+void BufferChain::append(const boost::shared_ptr<const void>& holder,
+                         const char* data,
+                         size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+
+  Slice slice;
+  slice.holder = holder;
+  slice.data = data;
+  slice.len = len;
+  slices_.push_back(slice);
+  readableBytes_ += len;
+  tail_ = NULL;
+}
+
+void BufferChain::appendFile(int fd, off_t offset, size_t len)
+{
+  assert(fd >= 0);
+  if (len == 0)
+  {
+    return;
+  }
+
+  Slice slice;
+  slice.fd = fd;
+  slice.offset = offset;
+  slice.len = len;
+  slices_.push_back(slice);
+  readableBytes_ += len;
+  fileBytes_ += len;
+  tail_ = NULL;
+}
+
+void BufferChain::append(BufferChain* chain)
+{
+  assert(chain != this);
+  if (chain->slices_.empty())
+  {
+    return;
+  }
+
+  slices_.insert(slices_.end(), chain->slices_.begin(), chain->slices_.end());
+  readableBytes_ += chain->readableBytes_;
+  fileBytes_ += chain->fileBytes_;
+  tail_ = chain->tail_;
+  chain->retrieveAll();
+}
+
+void BufferChain::prepend(const void* data, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+
+  // one allocation, short headers fit in the string itself
+  boost::shared_ptr<string> block(
+      boost::make_shared<string>(static_cast<const char*>(data), len));
+  Slice slice;
+  slice.holder = block;
+  slice.data = block->data();
+  slice.len = len;
+  slices_.push_front(slice);
+  readableBytes_ += len;
+}
+
+void BufferChain::retrieve(size_t len)
+{
+  assert(len <= readableBytes_);
+  readableBytes_ -= len;
+  while (len > 0)
+  {
+    assert(!slices_.empty());
+    Slice& slice = slices_.front();
+    if (slice.fd >= 0)
+    {
+      fileBytes_ -= std::min(len, slice.len);
+    }
+    if (len < slice.len)
+    {
+      if (slice.fd >= 0)
+      {
+        slice.offset += static_cast<off_t>(len);
+      }
+      else
+      {
+        slice.data += len;
+      }
+      slice.len -= len;
+      len = 0;
+    }
+    else
+    {
+      len -= slice.len;
+      if (slices_.size() == 1)
+      {
+        tail_ = NULL;
+      }
+      slices_.pop_front();
+    }
+  }
+}
+
+ssize_t BufferChain::writeFd(int fd, int* savedErrno)
+{
+  ssize_t n = 0;
+  if (!slices_.empty() && slices_.front().fd >= 0)
+  {
+    const Slice& file = slices_.front();
+    n = sockets::sendfile(fd, file.fd, file.offset, file.len);
+  }
+  else
+  {
+    // memory slices up to the next file region
+    struct iovec vec[kMaxIovecs];
+    int iovcnt = 0;
+    for (std::deque<Slice>::const_iterator it = slices_.begin();
+         it != slices_.end() && it->fd < 0 && iovcnt < kMaxIovecs; ++it)
+    {
+      vec[iovcnt].iov_base = const_cast<char*>(it->data);
+      vec[iovcnt].iov_len = it->len;
+      ++iovcnt;
+    }
+    n = sockets::writev(fd, vec, iovcnt);
+  }
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else
+  {
+    retrieve(n);
+  }
+  return n;
+}
+
@@ -0,0 +1,146 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_BUFFERCHAIN_H
+#define MUDUO_NET_BUFFERCHAIN_H
+
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
+
+#include <deque>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <assert.h>
+#include <sys/types.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class Buffer;
+
+///
+/// A queue of reference-counted byte slices, used as output buffer.
+///
+/// Small writes are copied into a tail block, whole Buffers and shared
+/// payloads are linked in without copying.  Queued bytes never move,
+/// so appending never reallocates what is already queued.
+///
+/// A slice can also be a region of a file, which is sent with
+/// sendfile(2) in its turn, without being read into memory.
+///
+/// @code
+/// +---------+--------------+---------+-------------+---------+----------+
+/// | block 0 | linked slice | block 1 | file region | block 2 | writable |
+/// +---------+--------------+---------+-------------+---------+----------+
+/// ^ peek()                                                   ^ tail_->beginWrite()
+/// @endcode
+class BufferChain : boost::noncopyable
+{
+ public:
+  static const size_t kBlockSize = 4096;
+  static const size_t kCopyThreshold = 1024;
+  static const int kMaxIovecs = 64;
+
+  BufferChain()
+    : readableBytes_(0),
+      fileBytes_(0),
+      tail_(NULL)
+  {
+  }
+
+  size_t readableBytes() const
+  { return readableBytes_; }
+
+  size_t numSlices() const
+  { return slices_.size(); }
+
+  /// Readable bytes that are in files, not in memory.
+  size_t fileBytes() const
+  { return fileBytes_; }
+
+  /// Copies data into the tail block.
+  void append(const char* /*restrict*/ data, size_t len);
+
+  void append(const void* /*restrict*/ data, size_t len)
+  {
+    append(static_cast<const char*>(data), len);
+  }
+
+  void append(const StringPiece& str)
+  {
+    append(str.data(), str.size());
+  }
+
+  /// Takes the readable bytes of @c buf, @c buf is left empty.
+  /// Large buffers are swapped in without copying.
+  void append(Buffer* buf);
+
+  /// Links [data, data+len) without copying,
+  /// @c holder keeps the bytes alive until they are written.
+  void append(const boost::shared_ptr<const void>& holder,
+              const char* data,
+              size_t len);
+
+  /// Moves all slices of @c chain to the end, without copying,
+  /// @c chain is left empty.
+  void append(BufferChain* chain);
+
+  /// Links [offset, offset+len) of file @c fd without reading it,
+  /// @c fd must stay open until the bytes are written.
+  void appendFile(int fd, off_t offset, size_t len);
+
+  /// Copies data into a new slice in front of everything, eg. a header
+  /// of a body that was linked in.
+  void prepend(const void* /*restrict*/ data, size_t len);
+
+  void retrieve(size_t len);
+
+  void retrieveAll()
+  {
+    slices_.clear();
+    readableBytes_ = 0;
+    fileBytes_ = 0;
+    tail_ = NULL;
+  }
+
+  /// Writes as many slices as possible with one writev(2), or a file
+  /// region with one sendfile(2), retrieves what has been written.
+  /// @return result of writev(2) or sendfile(2), @c errno is saved.
+  /// 0 means the file region is beyond the end of its file.
+  ssize_t writeFd(int fd, int* savedErrno);
+
+ private:
+  struct Slice
+  {
+    Slice()
+      : data(NULL), len(0), fd(-1), offset(0)
+    { }
+
+    boost::shared_ptr<const void> holder;
+    const char* data;
+    size_t len;
+    int fd;         // a file region if >= 0, data is NULL then
+    off_t offset;
+  };
+
+  size_t readableBytes_;
+  size_t fileBytes_;
+  std::deque<Slice> slices_;
+  // last block, owned by slices_.back(), NULL if bytes can't be appended in place
+  Buffer* tail_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_BUFFERCHAIN_H
@@ -0,0 +1,63 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/BufferPool.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t BufferPool::kScratchSize;
+const size_t BufferPool::kMaxPooledBytes;
+
+BufferPool::BufferPool()
+  : scratch_(kScratchSize),
+    pooledBytes_(0)
+{
+}
+
+Buffer* BufferPool::scratch()
+{
+  assert(scratch_.readableBytes() == 0);
+  // the storage may have been swapped into an output buffer
+  scratch_.ensureWritableBytes(kScratchSize);
+  return &scratch_;
+}
+
+void BufferPool::release(Buffer* buf)
+{
+  assert(buf->readableBytes() == 0);
+  size_t capacity = buf->internalCapacity();
+  if (capacity <= Buffer::kCheapPrepend)
+  {
+    return;  // nothing to take
+  }
+
+  Buffer empty(0);
+  if (pooledBytes_ + capacity <= kMaxPooledBytes)
+  {
+    pool_.push_back(empty);
+    pool_.back().swap(*buf);
+    pool_.back().retrieveAll();
+    pooledBytes_ += capacity;
+  }
+  else
+  {
+    buf->swap(empty);  // freed on return
+  }
+}
+
+void BufferPool::acquire(Buffer* buf)
+{
+  assert(buf->readableBytes() == 0);
+  if (buf->internalCapacity() <= Buffer::kCheapPrepend && !pool_.empty())
+  {
+    buf->swap(pool_.back());
+    pool_.pop_back();
+    pooledBytes_ -= buf->internalCapacity();
+  }
+}
@@ -0,0 +1,62 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_BUFFERPOOL_H
+#define MUDUO_NET_BUFFERPOOL_H
+
+#include <muduo/net/Buffer.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <deque>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Buffer storage shared by connections of one EventLoop.
+///
+/// Reads land in scratch() first, a connection keeps its own storage
+/// only while it holds a partial message.  Storage of drained buffers
+/// is kept here for the next connection that needs some.
+///
+/// Not thread safe, used in the loop thread only.
+class BufferPool : boost::noncopyable
+{
+ public:
+  static const size_t kScratchSize = 64*1024;
+  static const size_t kMaxPooledBytes = 16*1024*1024;
+
+  BufferPool();
+
+  /// Empty buffer with at least kScratchSize writable bytes.
+  Buffer* scratch();
+
+  /// Takes the storage of an empty @c buf, leaves it with none.
+  void release(Buffer* buf);
+
+  /// Gives an empty @c buf pooled storage, if it has none.
+  void acquire(Buffer* buf);
+
+  size_t pooledBytes() const { return pooledBytes_; }
+  size_t numPooled() const { return pool_.size(); }
+
+ private:
+  Buffer scratch_;
+  std::deque<Buffer> pool_;  // never copies what is pooled
+  size_t pooledBytes_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_BUFFERPOOL_H
@@ -52,6 +52,14 @@ typedef boost::function<void (const TcpConnectionPtr&,
                               Buffer*,
                               Timestamp)> MessageCallback;
 
+class InetAddress;
+
+// a datagram from peer is in [data, data+len), valid during the call only
+typedef boost::function<void (const InetAddress& peer,
+                              const char* data,
+                              size_t len,
+                              Timestamp)> DatagramCallback;
+
 void defaultConnectionCallback(const TcpConnectionPtr& conn);
 void defaultMessageCallback(const TcpConnectionPtr& conn,
                             Buffer* buffer,
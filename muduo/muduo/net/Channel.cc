@@ -28,6 +28,7 @@ Channel::Channel(EventLoop* loop, int fd__)
     revents_(0),
     index_(-1),
     logHup_(true),
+    edgeTriggered_(false),
     tied_(false),
     eventHandling_(false)
 {
@@ -44,6 +45,26 @@ void Channel::tie(const boost::shared_ptr<void>& obj)
   tied_ = true;
 }
 
+void Channel::enableWriting()
+{
+  bool wasNone = isNoneEvent();
+  events_ |= kWriteEvent;
+  // an edge-triggered channel without events isn't in the poller
+  if (!edgeTriggered_ || wasNone)
+  {
+    update();
+  }
+}
+
+void Channel::disableWriting()
+{
+  events_ &= ~kWriteEvent;
+  if (!edgeTriggered_ || isNoneEvent())
+  {
+    update();
+  }
+}
+
 void Channel::update()
 {
   loop_->updateChannel(this);
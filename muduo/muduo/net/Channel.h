@@ -58,15 +58,24 @@ class Channel : boost::noncopyable
   int fd() const { return fd_; }
   int events() const { return events_; }
   void set_revents(int revt) { revents_ = revt; } // used by pollers
-  // int revents() const { return revents_; }
+  int revents() const { return revents_; }
   bool isNoneEvent() const { return events_ == kNoneEvent; }
 
   void enableReading() { events_ |= kReadEvent; update(); }
-  // void disableReading() { events_ &= ~k  ReadEvent; update(); }
-  void enableWriting() { events_ |= kWriteEvent; update(); }
-  void disableWriting() { events_ &= ~kWriteEvent; update(); }
+  void disableReading() { events_ &= ~kReadEvent; update(); }
+  void enableWriting();
+  void disableWriting();
   void disableAll() { events_ = kNoneEvent; update(); }
   bool isWriting() const { return events_ & kWriteEvent; }
+  bool isReading() const { return events_ & kReadEvent; }
+
+  /// Registers with EPOLLET, writing is always registered and
+  /// enableWriting()/disableWriting() don't touch the poller, unless
+  /// there are no other events, eg. reading is stopped.
+  /// Must be set before enableReading(), and the owner must read and
+  /// write until EAGAIN.
+  void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+  bool edgeTriggered() const { return edgeTriggered_; }
 
   // for Poller
   int index() { return index_; }
@@ -94,6 +103,7 @@ class Channel : boost::noncopyable
   int        revents_;  // poll/epoll返回的事件
   int        index_; // used by Poller. 表示在poll的事件数组中的序号
   bool       logHup_;   // for POLLHUP
+  bool       edgeTriggered_;
 
   boost::weak_ptr<void> tie_;
   bool tied_;
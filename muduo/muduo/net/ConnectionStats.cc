@@ -0,0 +1,48 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/ConnectionStats.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+// skips locked adds of nothing, most events change only some counters
+inline void addIfAny(AtomicInt64* gauge, int64_t delta)
+{
+  if (delta != 0)
+  {
+    gauge->add(delta);
+  }
+}
+
+}
+
+void ConnectionGauge::add(const ConnectionStats& delta)
+{
+  addIfAny(&bytesReceived_, delta.bytesReceived);
+  addIfAny(&bytesSent_, delta.bytesSent);
+  addIfAny(&reads_, delta.reads);
+  addIfAny(&writes_, delta.writes);
+  addIfAny(&messages_, delta.messages);
+  addIfAny(&messageMicros_, delta.messageMicros);
+}
+
+ConnectionStats ConnectionGauge::get()
+{
+  ConnectionStats stats;
+  stats.bytesReceived = bytesReceived_.get();
+  stats.bytesSent = bytesSent_.get();
+  stats.reads = reads_.get();
+  stats.writes = writes_.get();
+  stats.messages = messages_.get();
+  stats.messageMicros = messageMicros_.get();
+  return stats;
+}
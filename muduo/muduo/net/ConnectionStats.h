@@ -0,0 +1,69 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_CONNECTIONSTATS_H
+#define MUDUO_NET_CONNECTIONSTATS_H
+
+#include <muduo/base/Atomic.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+/// Counters of a TcpConnection, updated in its loop thread.
+struct ConnectionStats
+{
+  int64_t bytesReceived;
+  int64_t bytesSent;
+  int64_t reads;          // read(2) and splice(2) from the socket
+  int64_t writes;         // write(2), writev(2), sendfile(2) and splice(2) to it
+  int64_t messages;       // MessageCallback calls
+  int64_t messageMicros;  // time spent in MessageCallback
+};
+
+///
+/// ConnectionStats summed over a group of connections, eg. of one loop.
+///
+/// Connections add what changed after each event, one writer thread
+/// per gauge keeps it cheap.  Read it in any thread.
+class ConnectionGauge : boost::noncopyable
+{
+ public:
+  void add(const ConnectionStats& delta);
+  ConnectionStats get();
+
+ private:
+  AtomicInt64 bytesReceived_;
+  AtomicInt64 bytesSent_;
+  AtomicInt64 reads_;
+  AtomicInt64 writes_;
+  AtomicInt64 messages_;
+  AtomicInt64 messageMicros_;
+};
+typedef boost::shared_ptr<ConnectionGauge> ConnectionGaugePtr;
+
+/// Load of the connections in one loop, see EventLoop::numConnections().
+struct LoadGauge : boost::noncopyable
+{
+  AtomicInt32 connections;
+  AtomicInt64 pendingOutputBytes;
+};
+typedef boost::shared_ptr<LoadGauge> LoadGaugePtr;
+
+}
+}
+
+#endif  // MUDUO_NET_CONNECTIONSTATS_H
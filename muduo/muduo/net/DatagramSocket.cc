@@ -0,0 +1,300 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/DatagramSocket.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int DatagramSocket::kDefaultBatchSize;
+const size_t DatagramSocket::kDefaultMaxDatagramSize;
+
+DatagramRing::DatagramRing(int slots, size_t slotSize)
+  : slotSize_(slotSize),
+    storage_(slots * slotSize),
+    addrs_(slots),
+    iovecs_(slots),
+    msgs_(slots),
+    head_(0),
+    count_(0)
+{
+  assert(slots > 0);
+  for (int i = 0; i < slots; ++i)
+  {
+    resetSlot(i);
+  }
+}
+
+void DatagramRing::resetSlot(int i)
+{
+  iovecs_[i].iov_base = &storage_[i * slotSize_];
+  iovecs_[i].iov_len = slotSize_;
+  struct msghdr& hdr = msgs_[i].msg_hdr;
+  bzero(&hdr, sizeof hdr);
+  hdr.msg_name = &addrs_[i];
+  hdr.msg_namelen = sizeof addrs_[i];
+  hdr.msg_iov = &iovecs_[i];
+  hdr.msg_iovlen = 1;
+  msgs_[i].msg_len = 0;
+}
+
+int DatagramRing::receive(int fd, int* savedErrno)
+{
+  assert(count_ == 0);
+  for (int i = 0; i < slots(); ++i)
+  {
+    // the kernel shrinks them to what was received
+    iovecs_[i].iov_len = slotSize_;
+    msgs_[i].msg_hdr.msg_namelen = sizeof addrs_[i];
+  }
+  int n = sockets::recvmmsg(fd, &msgs_[0], static_cast<unsigned int>(slots()));
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  return n;
+}
+
+void DatagramRing::push(const struct sockaddr* peer, socklen_t peerLen,
+                        const void* data, size_t len)
+{
+  assert(!full());
+  assert(len <= slotSize_);
+  int i = (head_ + count_) % slots();
+  memcpy(&storage_[i * slotSize_], data, len);
+  iovecs_[i].iov_len = len;
+  struct msghdr& hdr = msgs_[i].msg_hdr;
+  if (peer)
+  {
+    assert(peerLen <= sizeof addrs_[i]);
+    memcpy(&addrs_[i], peer, peerLen);
+    hdr.msg_name = &addrs_[i];
+    hdr.msg_namelen = peerLen;
+  }
+  else
+  {
+    hdr.msg_name = NULL;
+    hdr.msg_namelen = 0;
+  }
+  ++count_;
+}
+
+int DatagramRing::flush(int fd, int* savedErrno)
+{
+  int sent = 0;
+  while (count_ > 0)
+  {
+    // the queued slots may wrap around, send the part before the end first
+    int contiguous = std::min(count_, slots() - head_);
+    int n = sockets::sendmmsg(fd, &msgs_[head_], static_cast<unsigned int>(contiguous));
+    if (n < 0)
+    {
+      *savedErrno = errno;
+      return sent > 0 ? sent : -1;
+    }
+    head_ = (head_ + n) % slots();
+    count_ -= n;
+    sent += n;
+    if (n < contiguous)
+    {
+      break;
+    }
+  }
+  return sent;
+}
+
+void DatagramRing::drop()
+{
+  assert(count_ > 0);
+  head_ = (head_ + 1) % slots();
+  --count_;
+}
+
+DatagramSocket::DatagramSocket(EventLoop* loop,
+                               int sockfd,
+                               int batchSize,
+                               size_t maxDatagramSize)
+  : loop_(loop),
+    socket_(sockfd),
+    channel_(loop, sockfd),
+    receiveRing_(batchSize, maxDatagramSize),
+    sendRing_(batchSize, maxDatagramSize),
+    handlingRead_(false),
+    flushQueued_(false),
+    self_(new DatagramSocket*(this))
+{
+  bzero(&stats_, sizeof stats_);
+  channel_.setReadCallback(
+      boost::bind(&DatagramSocket::handleRead, this, _1));
+  channel_.setWriteCallback(
+      boost::bind(&DatagramSocket::handleWrite, this));
+}
+
+DatagramSocket::~DatagramSocket()
+{
+  if (!channel_.isNoneEvent())
+  {
+    channel_.disableAll();
+  }
+  if (channel_.index() >= 0)
+  {
+    channel_.remove();
+  }
+}
+
+void DatagramSocket::start()
+{
+  loop_->assertInLoopThread();
+  channel_.enableReading();
+}
+
+void DatagramSocket::send(const struct sockaddr* peer, socklen_t peerLen,
+                          const void* data, size_t len)
+{
+  loop_->assertInLoopThread();
+  if (len > sendRing_.slotSize())
+  {
+    // doesn't fit a slot, send it by itself
+    ssize_t n = peer ? ::sendto(socket_.fd(), data, len, 0, peer, peerLen)
+                     : ::send(socket_.fd(), data, len, 0);
+    ++stats_.sendCalls;
+    if (n < 0)
+    {
+      LOG_SYSERR << "DatagramSocket::send";
+      ++stats_.datagramsDropped;
+    }
+    else
+    {
+      ++stats_.datagramsSent;
+    }
+    return;
+  }
+
+  if (sendRing_.full())
+  {
+    flush();
+  }
+  if (sendRing_.full())
+  {
+    // socket buffer is full as well, UDP may lose it anyway
+    ++stats_.datagramsDropped;
+    return;
+  }
+  sendRing_.push(peer, peerLen, data, len);
+  if (!handlingRead_ && !flushQueued_ && !channel_.isWriting())
+  {
+    if (loop_->eventHandling() || loop_->callingPendingFunctors())
+    {
+      flushQueued_ = true;
+      loop_->queueInLoop(boost::bind(&DatagramSocket::queuedFlush,
+                                     boost::weak_ptr<DatagramSocket*>(self_)));
+    }
+    else
+    {
+      // eg. before loop(), nothing wakes the loop up for a queued flush
+      flush();
+    }
+  }
+}
+
+void DatagramSocket::handleRead(Timestamp receiveTime)
+{
+  loop_->assertInLoopThread();
+  int savedErrno = 0;
+  int n = receiveRing_.receive(socket_.fd(), &savedErrno);
+  ++stats_.receiveCalls;
+  if (n > 0)
+  {
+    stats_.datagramsReceived += n;
+    handlingRead_ = true;
+    for (int i = 0; i < n; ++i)
+    {
+      if (receiveRing_.truncated(i))
+      {
+        LOG_WARN << "DatagramSocket::handleRead - datagram truncated to "
+                 << receiveRing_.slotSize() << " bytes";
+      }
+      InetAddress peer(receiveRing_.peer(i));
+      messageCallback_(peer, receiveRing_.data(i), receiveRing_.length(i), receiveTime);
+    }
+    handlingRead_ = false;
+    // replies of the whole batch
+    flush();
+  }
+  else if (n < 0 && savedErrno != EAGAIN)
+  {
+    // eg. ECONNREFUSED of a connected socket
+    errno = savedErrno;
+    LOG_SYSERR << "DatagramSocket::handleRead";
+  }
+}
+
+void DatagramSocket::handleWrite()
+{
+  loop_->assertInLoopThread();
+  flush();
+}
+
+void DatagramSocket::queuedFlush(const boost::weak_ptr<DatagramSocket*>& weakSelf)
+{
+  boost::shared_ptr<DatagramSocket*> self(weakSelf.lock());
+  if (self)
+  {
+    (*self)->flush();
+  }
+}
+
+void DatagramSocket::flush()
+{
+  flushQueued_ = false;
+  while (sendRing_.queued() > 0)
+  {
+    int savedErrno = 0;
+    int n = sendRing_.flush(socket_.fd(), &savedErrno);
+    ++stats_.sendCalls;
+    if (n > 0)
+    {
+      stats_.datagramsSent += n;
+    }
+    else if (savedErrno == EAGAIN)
+    {
+      break;
+    }
+    else
+    {
+      // the error is about the oldest one, don't get stuck on it
+      errno = savedErrno;
+      LOG_SYSERR << "DatagramSocket::flush";
+      sendRing_.drop();
+      ++stats_.datagramsDropped;
+    }
+  }
+
+  // wait for room in the socket buffer, then flush the rest
+  if (sendRing_.queued() > 0 && !channel_.isWriting())
+  {
+    channel_.enableWriting();
+  }
+  else if (sendRing_.queued() == 0 && channel_.isWriting())
+  {
+    channel_.disableWriting();
+  }
+}
@@ -0,0 +1,130 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_DATAGRAMSOCKET_H
+#define MUDUO_NET_DATAGRAMSOCKET_H
+
+#include <muduo/net/Callbacks.h>
+#include <muduo/net/Channel.h>
+#include <muduo/net/DatagramStats.h>
+#include <muduo/net/Socket.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Fixed slots for datagrams, with mmsghdrs pointing to them.
+///
+/// Used either as one batch of recvmmsg(2), or as a queue of datagrams
+/// waiting for sendmmsg(2).  Slots are allocated once and reused.
+class DatagramRing : boost::noncopyable
+{
+ public:
+  DatagramRing(int slots, size_t slotSize);
+
+  int slots() const { return static_cast<int>(msgs_.size()); }
+  size_t slotSize() const { return slotSize_; }
+
+  // receiving, into slots [0, n)
+
+  /// @return result of recvmmsg(2), @c errno is saved
+  int receive(int fd, int* savedErrno);
+  const char* data(int i) const { return &storage_[i * slotSize_]; }
+  size_t length(int i) const { return msgs_[i].msg_len; }
+  const struct sockaddr_storage& peer(int i) const { return addrs_[i]; }
+  bool truncated(int i) const { return msgs_[i].msg_hdr.msg_flags & MSG_TRUNC; }
+
+  // sending, from head_ round the ring
+
+  int queued() const { return count_; }
+  bool full() const { return count_ == slots(); }
+  /// Copies a datagram in, @c peer is NULL for a connected socket.
+  void push(const struct sockaddr* peer, socklen_t peerLen,
+            const void* data, size_t len);
+  /// Sends queued datagrams with as few sendmmsg(2) as possible.
+  /// @return datagrams sent, -1 if none, @c errno is saved
+  int flush(int fd, int* savedErrno);
+  /// Gives up the oldest datagram.
+  void drop();
+
+ private:
+  void resetSlot(int i);
+
+  const size_t slotSize_;
+  std::vector<char> storage_;
+  std::vector<struct sockaddr_storage> addrs_;
+  std::vector<struct iovec> iovecs_;
+  std::vector<struct mmsghdr> msgs_;
+  int head_;
+  int count_;
+};
+
+///
+/// A UDP socket in an EventLoop, reading and writing in batches.
+///
+/// Datagrams sent from MessageCallback are flushed together after the
+/// whole batch is handled, others from callbacks of the loop at the end
+/// of the iteration, the rest right away.
+/// Destroyed in loop thread.
+class DatagramSocket : boost::noncopyable
+{
+ public:
+  static const int kDefaultBatchSize = 32;
+  static const size_t kDefaultMaxDatagramSize = 4096;
+
+  DatagramSocket(EventLoop* loop, int sockfd, int batchSize, size_t maxDatagramSize);
+  ~DatagramSocket();
+
+  void setMessageCallback(const DatagramCallback& cb)
+  { messageCallback_ = cb; }
+
+  /// Starts reading, in loop thread.
+  void start();
+
+  /// @c peer is NULL for a connected socket, in loop thread.
+  void send(const struct sockaddr* peer, socklen_t peerLen,
+            const void* data, size_t len);
+
+  const DatagramStats& stats() const { return stats_; }
+
+ private:
+  void handleRead(Timestamp receiveTime);
+  void handleWrite();
+  void flush();
+  // the flush queued by send(), skipped if the socket is gone
+  static void queuedFlush(const boost::weak_ptr<DatagramSocket*>& weakSelf);
+
+  EventLoop* loop_;
+  Socket socket_;
+  Channel channel_;
+  DatagramCallback messageCallback_;
+  DatagramRing receiveRing_;
+  DatagramRing sendRing_;
+  bool handlingRead_;
+  bool flushQueued_;
+  DatagramStats stats_;
+  boost::shared_ptr<DatagramSocket*> self_;  // expires in dtor
+};
+
+}
+}
+
+#endif  // MUDUO_NET_DATAGRAMSOCKET_H
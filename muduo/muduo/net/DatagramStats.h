@@ -0,0 +1,34 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_DATAGRAMSTATS_H
+#define MUDUO_NET_DATAGRAMSTATS_H
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+/// Counters of a UdpServer or UdpClient, updated in its loop thread.
+struct DatagramStats
+{
+  int64_t receiveCalls;       // recvmmsg(2)
+  int64_t datagramsReceived;
+  int64_t sendCalls;          // sendmmsg(2) and sendto(2)
+  int64_t datagramsSent;
+  int64_t datagramsDropped;   // send queue full, or sendto(2) failed
+};
+
+}
+}
+
+#endif  // MUDUO_NET_DATAGRAMSTATS_H
@@ -11,14 +11,19 @@
 #include <muduo/base/Logging.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Singleton.h>
+#include <muduo/net/BufferPool.h>
 #include <muduo/net/Channel.h>
+#include <muduo/net/LoopStats.h>
 #include <muduo/net/Poller.h>
+#include <muduo/net/SlabAllocator.h>
 #include <muduo/net/SocketsOps.h>
 #include <muduo/net/TimerQueue.h>
 
 #include <boost/bind.hpp>
 
 #include <signal.h>
+#include <stdlib.h>  // getenv
+#include <strings.h>  // bzero
 #include <sys/eventfd.h>
 
 using namespace muduo;
@@ -30,6 +35,11 @@ __thread EventLoop* t_loopInThisThread = 0;
 
 const int kPollTimeMs = 10000;
 
+inline int64_t microsBetween(Timestamp start, Timestamp end)
+{
+  return end.microSecondsSinceEpoch() - start.microSecondsSinceEpoch();
+}
+
 int createEventfd()
 {
   int evtfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
@@ -72,7 +82,13 @@ EventLoop::EventLoop()
     timerQueue_(new TimerQueue(this)),
     wakeupFd_(createEventfd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    currentActiveChannel_(NULL)
+    currentActiveChannel_(NULL),
+    wakeupPending_(0),
+    loadGauge_(new LoadGauge),
+    connectionGauge_(new ConnectionGauge),
+    loopStats_(new LoopStats),
+    slabAllocator_(new SlabAllocator),
+    bufferPool_(new BufferPool)
 {
   LOG_TRACE << "EventLoop created " << this << " in thread " << threadId_;
   if (t_loopInThisThread)
@@ -84,6 +100,8 @@ EventLoop::EventLoop()
   {
     t_loopInThisThread = this;
   }
+  bzero(&syscallStats_, sizeof syscallStats_);
+  setLoopStats(::getenv("MUDUO_LOOP_STATS") != NULL);
   wakeupChannel_->setReadCallback(
       boost::bind(&EventLoop::handleRead, this));
   // we are always reading the wakeupfd
@@ -104,9 +122,16 @@ void EventLoop::loop()
   quit_ = false;
   LOG_TRACE << "EventLoop " << this << " start looping";
 
+  Timestamp busyEnd;  // end of last timed iteration, ie. poll start
   while (!quit_)
   {
     activeChannels_.clear();
+    // taken once, an iteration is timed all or nothing
+    LoopStats* stats = collectLoopStats_.get() ? get_pointer(loopStats_) : NULL;
+    if (stats && !busyEnd.valid())
+    {
+      busyEnd = Timestamp::now();
+    }
     pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
     ++iteration_;
     if (Logger::logLevel() <= Logger::TRACE)
@@ -115,15 +140,39 @@ void EventLoop::loop()
     }
     // TODO sort channel by priority
     eventHandling_ = true;
+    Timestamp start(pollReturnTime_);
     for (ChannelList::iterator it = activeChannels_.begin();
         it != activeChannels_.end(); ++it)
     {
       currentActiveChannel_ = *it;
+      // the channel may be gone after handleEvent()
+      int fd = currentActiveChannel_->fd();
       currentActiveChannel_->handleEvent(pollReturnTime_);
+      if (stats)
+      {
+        Timestamp end(Timestamp::now());
+        stats->addChannel(fd, fd == timerQueue_->fd(), microsBetween(start, end), start);
+        start = end;
+      }
     }
     currentActiveChannel_ = NULL;
     eventHandling_ = false;
-    doPendingFunctors();
+    size_t functors = doPendingFunctors();
+    if (stats)
+    {
+      Timestamp end(Timestamp::now());
+      if (functors > 0)
+      {
+        stats->addFunctors(functors, microsBetween(start, end));
+      }
+      stats->addPoll(microsBetween(busyEnd, pollReturnTime_));
+      stats->addIteration(microsBetween(pollReturnTime_, end));
+      busyEnd = end;
+    }
+    else
+    {
+      busyEnd = Timestamp();
+    }
   }
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
@@ -153,12 +202,11 @@ void EventLoop::runInLoop(const Functor& cb)
 
 void EventLoop::queueInLoop(const Functor& cb)
 {
-  {
-  MutexLockGuard lock(mutex_);
-  pendingFunctors_.push_back(cb);
-  }
+  pendingFunctors_.put(cb);
 
-  if (!isInLoopThread() || callingPendingFunctors_)
+  // only the first post since last draining needs to wake up the loop
+  if ((!isInLoopThread() || callingPendingFunctors_)
+      && __sync_bool_compare_and_swap(&wakeupPending_, 0, 1))
   {
     wakeup();
   }
@@ -186,6 +234,16 @@ void EventLoop::cancel(TimerId timerId)
   return timerQueue_->cancel(timerId);
 }
 
+void EventLoop::setTimerSlack(double seconds)
+{
+  timerQueue_->setSlack(seconds);
+}
+
+bool EventLoop::supportsEdgeTriggered() const
+{
+  return poller_->supportsEdgeTriggered();
+}
+
 void EventLoop::updateChannel(Channel* channel)
 {
   assert(channel->ownerLoop() == this);
@@ -232,21 +290,15 @@ void EventLoop::handleRead()
   }
 }
 
-void EventLoop::doPendingFunctors()
+size_t EventLoop::doPendingFunctors()
 {
-  std::vector<Functor> functors;
   callingPendingFunctors_ = true;
-
-  {
-  MutexLockGuard lock(mutex_);
-  functors.swap(pendingFunctors_);
-  }
-
-  for (size_t i = 0; i < functors.size(); ++i)
-  {
-    functors[i]();
-  }
+  // cleared before taking, so a post we don't take will wake up the loop
+  __sync_lock_test_and_set(&wakeupPending_, 0);
+  __sync_synchronize();
+  size_t n = pendingFunctors_.takeAll(&EventLoop::callFunctor);
   callingPendingFunctors_ = false;
+  return n;
 }
 
 void EventLoop::printActiveChannels() const
@@ -16,11 +16,15 @@
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include <muduo/base/Atomic.h>
+#include <muduo/base/MpscQueue.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
 #include <muduo/base/Timestamp.h>
 #include <muduo/net/Callbacks.h>
+#include <muduo/net/ConnectionStats.h>
 #include <muduo/net/TimerId.h>
 
 namespace muduo
@@ -28,8 +32,11 @@ namespace muduo
 namespace net
 {
 
+class BufferPool;
 class Channel;
+class LoopStats;
 class Poller;
+class SlabAllocator;
 class TimerQueue;
 
 ///
@@ -60,6 +67,38 @@ class EventLoop : boost::noncopyable
 
   int64_t iteration() const { return iteration_; }
 
+  // load of this loop, maintained by TcpConnection,
+  // read by EventLoopThreadPool from other threads.
+  int numConnections() { return loadGauge_->connections.get(); }
+  int64_t pendingOutputBytes() { return loadGauge_->pendingOutputBytes.get(); }
+  void addConnections(int delta) { loadGauge_->connections.add(delta); }
+  void addPendingOutputBytes(int64_t delta) { loadGauge_->pendingOutputBytes.add(delta); }
+  // held by connections, which may outlive the loop
+  const LoadGaugePtr& loadGauge() const { return loadGauge_; }
+
+  /// Syscalls made for this loop, besides one poll per iteration().
+  /// Counted by the poller and TcpConnection, in loop thread.
+  struct SyscallStats
+  {
+    int64_t pollerUpdates;  // epoll_ctl
+    int64_t timerUpdates;   // timerfd_settime
+    int64_t reads;
+    int64_t writes;
+  };
+  SyscallStats& syscallStats() { return syscallStats_; }
+
+  /// Times each phase of loop() into loopStats(), one clock read per
+  /// channel handled.  Off by default, MUDUO_LOOP_STATS turns it on for
+  /// every loop.  Thread safe, counts from the next iteration.
+  void setLoopStats(bool on) { collectLoopStats_.getAndSet(on ? 1 : 0); }
+  /// Thread safe, the loop keeps writing it.
+  const LoopStats& loopStats() const { return *loopStats_; }
+
+  /// Traffic of connections in this loop, added by TcpConnection.
+  /// Thread safe.
+  /// Connections hold it, it may outlive the loop.
+  const ConnectionGaugePtr& connectionGauge() const { return connectionGauge_; }
+
   /// Runs callback immediately in the loop thread.
   /// It wakes up the loop, and run the cb.
   /// If in the same loop thread, cb is run within the function.
@@ -93,10 +132,24 @@ class EventLoop : boost::noncopyable
   ///
   void cancel(TimerId timerId);
 
+  ///
+  /// Lets timers fire up to @c seconds late, those due within it share
+  /// one wakeup, and adding a timer rearms timerfd less often.
+  /// 0 by default.  In loop thread.
+  ///
+  void setTimerSlack(double seconds);
+
   // internal usage
   void wakeup();
+  bool supportsEdgeTriggered() const;
   void updateChannel(Channel* channel);   // 在Poller中添加或者更新通道
   void removeChannel(Channel* channel);   // 在Poller中移除通道
+  // memory for connections living in this loop, may be used in any thread,
+  // connections hold it, it may outlive the loop
+  const boost::shared_ptr<SlabAllocator>& slabAllocator() const
+  { return slabAllocator_; }
+  // buffer storage for connections living in this loop, loop thread only
+  BufferPool* bufferPool() { return get_pointer(bufferPool_); }
 
   // pid_t threadId() const { return threadId_; }
   void assertInLoopThread()
@@ -107,7 +160,7 @@ class EventLoop : boost::noncopyable
     }
   }
   bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
-  // bool callingPendingFunctors() const { return callingPendingFunctors_; }
+  bool callingPendingFunctors() const { return callingPendingFunctors_; }
   bool eventHandling() const { return eventHandling_; }
 
   static EventLoop* getEventLoopOfCurrentThread();
@@ -115,7 +168,9 @@ class EventLoop : boost::noncopyable
  private:
   void abortNotInLoopThread();
   void handleRead();  // waked up
-  void doPendingFunctors();
+  // returns how many were called
+  size_t doPendingFunctors();
+  static void callFunctor(const Functor& cb) { cb(); }
 
   void printActiveChannels() const; // DEBUG
 
@@ -136,8 +191,15 @@ class EventLoop : boost::noncopyable
   boost::scoped_ptr<Channel> wakeupChannel_;
   ChannelList activeChannels_;      // Poller返回的活动通道
   Channel* currentActiveChannel_;   // 当前正在处理的活动通道
-  MutexLock mutex_;
-  std::vector<Functor> pendingFunctors_; // @BuardedBy mutex_
+  MpscQueue<Functor> pendingFunctors_;
+  int wakeupPending_; /* atomic */ // set by the first post after draining
+  LoadGaugePtr loadGauge_;
+  SyscallStats syscallStats_;
+  ConnectionGaugePtr connectionGauge_;
+  AtomicInt32 collectLoopStats_;
+  boost::scoped_ptr<LoopStats> loopStats_;
+  boost::shared_ptr<SlabAllocator> slabAllocator_;
+  boost::scoped_ptr<BufferPool> bufferPool_;
 };
 
 }
@@ -29,8 +29,20 @@ EventLoopThread::EventLoopThread(const ThreadInitCallback& cb)
 EventLoopThread::~EventLoopThread()
 {
   exiting_ = true;
-  loop_->quit();
-  thread_.join();
+  {
+    // NULL once loop() returned, the loop is gone then
+    MutexLockGuard lock(mutex_);
+    if (loop_ != NULL)
+    {
+      // not quit(), loop() would forget it if not looping yet,
+      // a functor runs in loop()
+      loop_->runInLoop(boost::bind(&EventLoop::quit, loop_));
+    }
+  }
+  if (thread_.started())
+  {
+    thread_.join();
+  }
 }
 
 EventLoop* EventLoopThread::startLoop()
@@ -66,5 +78,7 @@ void EventLoopThread::threadFunc()
 
   loop.loop();
   //assert(exiting_);
+  MutexLockGuard lock(mutex_);
+  loop_ = NULL;
 }
 
@@ -10,6 +10,7 @@
 
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/EventLoopThread.h>
+#include <muduo/net/InetAddress.h>
 
 #include <boost/bind.hpp>
 
@@ -21,7 +22,9 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop)
   : baseLoop_(baseLoop),
     started_(false),
     numThreads_(0),
-    next_(0)
+    policy_(kRoundRobin),
+    next_(0),
+    seed_(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this)) | 1)
 {
 }
 
@@ -67,3 +70,85 @@ EventLoop* EventLoopThreadPool::getNextLoop()
   return loop;
 }
 
+EventLoop* EventLoopThreadPool::getLoopForConnection(const InetAddress& peerAddr)
+{
+  baseLoop_->assertInLoopThread();
+  EventLoop* loop = baseLoop_;
+
+  if (!loops_.empty())
+  {
+    switch (policy_)
+    {
+      case kRoundRobin:
+        loop = getNextLoop();
+        break;
+      case kLeastConnections:
+        loop = loops_[0];
+        for (size_t i = 1; i < loops_.size(); ++i)
+        {
+          if (loops_[i]->numConnections() < loop->numConnections())
+          {
+            loop = loops_[i];
+          }
+        }
+        break;
+      case kLeastPendingBytes:
+        loop = loops_[0];
+        for (size_t i = 1; i < loops_.size(); ++i)
+        {
+          if (loops_[i]->pendingOutputBytes() < loop->pendingOutputBytes())
+          {
+            loop = loops_[i];
+          }
+        }
+        break;
+      case kPowerOfTwoChoices:
+        if (loops_.size() == 1)
+        {
+          loop = loops_[0];
+        }
+        else
+        {
+          // xorshift, good enough for picking loops
+          seed_ ^= seed_ << 13;
+          seed_ ^= seed_ >> 17;
+          seed_ ^= seed_ << 5;
+          size_t n = loops_.size();
+          size_t i = seed_ % n;
+          size_t j = (i + 1 + seed_ / n % (n - 1)) % n;  // j != i
+          loop = loops_[i]->numConnections() <= loops_[j]->numConnections()
+                 ? loops_[i] : loops_[j];
+        }
+        break;
+      case kHashByPeerAddress:
+        loop = getLoopForHash(peerAddr.ipHash());
+        break;
+    }
+  }
+  return loop;
+}
+
+EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode)
+{
+  baseLoop_->assertInLoopThread();
+  EventLoop* loop = baseLoop_;
+
+  if (!loops_.empty())
+  {
+    loop = loops_[hashCode % loops_.size()];
+  }
+  return loop;
+}
+
+std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
+{
+  baseLoop_->assertInLoopThread();
+  if (loops_.empty())
+  {
+    return std::vector<EventLoop*>(1, baseLoop_);
+  }
+  else
+  {
+    return loops_;
+  }
+}
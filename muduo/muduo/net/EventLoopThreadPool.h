@@ -6,13 +6,14 @@
 
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 //
-// This is an internal header file, you should not include this.
+// This is a public header file, it must only include public header files.
 
 #ifndef MUDUO_NET_EVENTLOOPTHREADPOOL_H
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
 
 #include <muduo/base/Condition.h>
 #include <muduo/base/Mutex.h>
+#include <muduo/base/Types.h>
 
 #include <vector>
 #include <boost/function.hpp>
@@ -27,24 +28,46 @@ namespace net
 
 class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool : boost::noncopyable
 {
  public:
   typedef boost::function<void(EventLoop*)> ThreadInitCallback;
 
+  /// How getLoopForConnection() picks a loop.
+  /// Loads are read from EventLoop counters, without locking.
+  enum SelectionPolicy
+  {
+    kRoundRobin,  // default
+    kLeastConnections,
+    kLeastPendingBytes,  // fewest bytes waiting in output buffers
+    kPowerOfTwoChoices,  // fewer connections of two random loops
+    kHashByPeerAddress  // same peer IP goes to same loop
+  };
+
   EventLoopThreadPool(EventLoop* baseLoop);
   ~EventLoopThreadPool();
   void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+  void setSelectionPolicy(SelectionPolicy policy) { policy_ = policy; }
   void start(const ThreadInitCallback& cb = ThreadInitCallback());
+  // round-robin
   EventLoop* getNextLoop();
+  /// Picks a loop for a new connection, according to the policy.
+  EventLoop* getLoopForConnection(const InetAddress& peerAddr);
+  /// Same hash code, same loop.
+  EventLoop* getLoopForHash(size_t hashCode);
+  /// All I/O loops, or the base loop if there is no thread.
+  std::vector<EventLoop*> getAllLoops();
 
  private:
 
   EventLoop* baseLoop_;
   bool started_;
   int numThreads_;
+  SelectionPolicy policy_;
   int next_;
+  uint32_t seed_;  // for kPowerOfTwoChoices
   boost::ptr_vector<EventLoopThread> threads_;
   std::vector<EventLoop*> loops_;
 };
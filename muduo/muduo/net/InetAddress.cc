@@ -11,6 +11,9 @@
 #include <muduo/net/Endian.h>
 #include <muduo/net/SocketsOps.h>
 
+#include <algorithm>
+
+#include <string.h>
 #include <strings.h>  // bzero
 #include <netinet/in.h>
 
@@ -37,7 +40,7 @@ static const in_addr_t kInaddrAny = INADDR_ANY;
 using namespace muduo;
 using namespace muduo::net;
 
-BOOST_STATIC_ASSERT(sizeof(InetAddress) == sizeof(struct sockaddr_in));
+BOOST_STATIC_ASSERT(sizeof(InetAddress) <= sizeof(struct sockaddr_storage));
 
 InetAddress::InetAddress(uint16_t port)
 {
@@ -47,23 +50,112 @@ InetAddress::InetAddress(uint16_t port)
   addr_.sin_port = sockets::hostToNetwork16(port);
 }
 
+InetAddress::InetAddress(uint16_t port, bool ipv6)
+{
+  if (ipv6)
+  {
+    bzero(&addr6_, sizeof addr6_);
+    addr6_.sin6_family = AF_INET6;
+    addr6_.sin6_addr = in6addr_any;
+    addr6_.sin6_port = sockets::hostToNetwork16(port);
+  }
+  else
+  {
+    bzero(&addr_, sizeof addr_);
+    addr_.sin_family = AF_INET;
+    addr_.sin_addr.s_addr = sockets::hostToNetwork32(kInaddrAny);
+    addr_.sin_port = sockets::hostToNetwork16(port);
+  }
+}
+
 InetAddress::InetAddress(const StringPiece& ip, uint16_t port)
 {
-  bzero(&addr_, sizeof addr_);
-  sockets::fromIpPort(ip.data(), port, &addr_);
+  // StringPiece may not be NUL terminated
+  string host(ip.data(), ip.size());
+  if (host.find(':') != string::npos)
+  {
+    bzero(&addr6_, sizeof addr6_);
+    sockets::fromIpPort(host.c_str(), port, &addr6_);
+  }
+  else
+  {
+    bzero(&addr_, sizeof addr_);
+    sockets::fromIpPort(host.c_str(), port, &addr_);
+  }
+}
+
+InetAddress::InetAddress(const struct sockaddr_storage& addr)
+{
+  bzero(&addrUn_, sizeof addrUn_);
+  switch (addr.ss_family)
+  {
+    case AF_INET6:
+      memcpy(&addr6_, &addr, sizeof addr6_);
+      break;
+    case AF_UNIX:
+      memcpy(&addrUn_, &addr, sizeof addrUn_);
+      break;
+    default:
+      memcpy(&addr_, &addr, sizeof addr_);
+      break;
+  }
+}
+
+InetAddress InetAddress::unixDomain(const StringPiece& path)
+{
+  struct sockaddr_un addr;
+  bzero(&addr, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  size_t len = std::min(static_cast<size_t>(path.size()), sizeof addr.sun_path - 1);
+  memcpy(addr.sun_path, path.data(), len);
+  return InetAddress(addr);
+}
+
+socklen_t InetAddress::getSockLen() const
+{
+  switch (family())
+  {
+    case AF_INET6:
+      return static_cast<socklen_t>(sizeof addr6_);
+    case AF_UNIX:
+      return static_cast<socklen_t>(sizeof addrUn_);
+    default:
+      return static_cast<socklen_t>(sizeof addr_);
+  }
 }
 
 string InetAddress::toIpPort() const
 {
-  char buf[32];
-  sockets::toIpPort(buf, sizeof buf, addr_);
+  char buf[sizeof addrUn_.sun_path + 16];
+  sockets::toIpPort(buf, sizeof buf, getSockAddr());
   return buf;
 }
 
 string InetAddress::toIp() const
 {
-  char buf[32];
-  sockets::toIp(buf, sizeof buf, addr_);
+  char buf[sizeof addrUn_.sun_path + 16];
+  sockets::toIp(buf, sizeof buf, getSockAddr());
   return buf;
 }
 
+size_t InetAddress::ipHash() const
+{
+  switch (family())
+  {
+    case AF_INET6:
+    {
+      // FNV-1a
+      const unsigned char* p = addr6_.sin6_addr.s6_addr;
+      size_t h = 2166136261u;
+      for (size_t i = 0; i < sizeof addr6_.sin6_addr.s6_addr; ++i)
+      {
+        h = (h ^ p[i]) * 16777619u;
+      }
+      return h;
+    }
+    case AF_UNIX:
+      return 0;
+    default:
+      return addr_.sin_addr.s_addr;
+  }
+}
@@ -13,8 +13,11 @@
 
 #include <muduo/base/copyable.h>
 #include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
 
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 namespace muduo
 {
@@ -22,7 +25,7 @@ namespace net
 {
 
 ///
-/// Wrapper of sockaddr_in.
+/// Wrapper of sockaddr_in, sockaddr_in6 and sockaddr_un.
 ///
 /// This is an POD interface class.
 class InetAddress : public muduo::copyable
@@ -32,8 +35,11 @@ class InetAddress : public muduo::copyable
   /// Mostly used in TcpServer listening.
   explicit InetAddress(uint16_t port);
 
+  /// Same, listening on IPv6 (and IPv4 mapped) if @c ipv6.
+  InetAddress(uint16_t port, bool ipv6);
+
   /// Constructs an endpoint with given ip and port.
-  /// @c ip should be "1.2.3.4"
+  /// @c ip should be "1.2.3.4", or "::1" for IPv6
   InetAddress(const StringPiece& ip, uint16_t port);
 
   /// Constructs an endpoint with given struct @c sockaddr_in
@@ -42,21 +48,57 @@ class InetAddress : public muduo::copyable
     : addr_(addr)
   { }
 
+  InetAddress(const struct sockaddr_in6& addr)
+    : addr6_(addr)
+  { }
+
+  InetAddress(const struct sockaddr_un& addr)
+    : addrUn_(addr)
+  { }
+
+  /// Any of the three, by its family.
+  InetAddress(const struct sockaddr_storage& addr);
+
+  /// Unix-domain socket at @c path, eg. "/tmp/sidecar.sock".
+  /// The path is truncated to what fits in sun_path.
+  static InetAddress unixDomain(const StringPiece& path);
+
+  sa_family_t family() const { return addr_.sin_family; }
+
+  /// "1.2.3.4", "::1", or the path of a Unix-domain socket
   string toIp() const;
+  /// "1.2.3.4:80", "[::1]:80", or the path of a Unix-domain socket
   string toIpPort() const;
   string toHostPort() const __attribute__ ((deprecated))
   { return toIpPort(); }
 
   // default copy/assignment are Okay
 
+  const struct sockaddr* getSockAddr() const
+  { return static_cast<const struct sockaddr*>(implicit_cast<const void*>(&addr6_)); }
+  socklen_t getSockLen() const;
+
+  /// IPv4 only.
   const struct sockaddr_in& getSockAddrInet() const { return addr_; }
   void setSockAddrInet(const struct sockaddr_in& addr) { addr_ = addr; }
 
+  /// IPv4 only.
   uint32_t ipNetEndian() const { return addr_.sin_addr.s_addr; }
-  uint16_t portNetEndian() const { return addr_.sin_port; }
+  /// Same place in sockaddr_in and sockaddr_in6, 0 for Unix-domain.
+  uint16_t portNetEndian() const
+  { return family() == AF_UNIX ? 0 : addr_.sin_port; }
+
+  /// Of the ip only, the port is left out.
+  /// Unnamed Unix-domain peers all hash the same.
+  size_t ipHash() const;
 
  private:
-  struct sockaddr_in addr_;
+  union
+  {
+    struct sockaddr_in addr_;
+    struct sockaddr_in6 addr6_;
+    struct sockaddr_un addrUn_;
+  };
 };
 
 }
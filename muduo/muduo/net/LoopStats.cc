@@ -0,0 +1,168 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/LoopStats.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#undef __STDC_FORMAT_MACROS
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+int lagBucket(int64_t micros)
+{
+  int bucket = 0;
+  while (micros > 0 && bucket < LoopStats::kLagBuckets-1)
+  {
+    micros >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}
+
+const int LoopStats::kLagBuckets;
+
+LoopStats::LoopStats()
+  : iterations_(0),
+    pollMicros_(0),
+    channelCallbacks_(0),
+    channelMicros_(0),
+    timerCallbacks_(0),
+    timerMicros_(0),
+    functors_(0),
+    functorBatches_(0),
+    functorMicros_(0),
+    maxPendingFunctors_(0),
+    slowestMicros_(0),
+    slowestFd_(-1),
+    slowestTime_(0)
+{
+  for (int i = 0; i < kLagBuckets; ++i)
+  {
+    lag_[i] = 0;
+  }
+}
+
+void LoopStats::addPoll(int64_t micros)
+{
+  pollMicros_ = pollMicros_ + micros;
+}
+
+void LoopStats::addChannel(int fd, bool timer, int64_t micros, Timestamp when)
+{
+  if (timer)
+  {
+    timerCallbacks_ = timerCallbacks_ + 1;
+    timerMicros_ = timerMicros_ + micros;
+  }
+  else
+  {
+    channelCallbacks_ = channelCallbacks_ + 1;
+    channelMicros_ = channelMicros_ + micros;
+  }
+  if (micros > slowestMicros_)
+  {
+    slowestMicros_ = micros;
+    slowestFd_ = fd;
+    slowestTime_ = when.microSecondsSinceEpoch();
+  }
+}
+
+void LoopStats::addFunctors(size_t count, int64_t micros)
+{
+  int64_t n = static_cast<int64_t>(count);
+  functors_ = functors_ + n;
+  functorBatches_ = functorBatches_ + 1;
+  functorMicros_ = functorMicros_ + micros;
+  if (n > maxPendingFunctors_)
+  {
+    maxPendingFunctors_ = n;
+  }
+}
+
+void LoopStats::addIteration(int64_t busyMicros)
+{
+  iterations_ = iterations_ + 1;
+  int bucket = lagBucket(busyMicros);
+  lag_[bucket] = lag_[bucket] + 1;
+}
+
+int64_t LoopStats::lagPercentileMicros(double percent) const
+{
+  int64_t total = 0;
+  for (int i = 0; i < kLagBuckets; ++i)
+  {
+    total += lag_[i];
+  }
+  int64_t seen = 0;
+  for (int i = 0; i < kLagBuckets; ++i)
+  {
+    seen += lag_[i];
+    if (total > 0 && static_cast<double>(seen) >= static_cast<double>(total) * percent / 100.0)
+    {
+      return static_cast<int64_t>(1) << i;
+    }
+  }
+  return static_cast<int64_t>(1) << (kLagBuckets-1);
+}
+
+string LoopStats::toString() const
+{
+  char buf[256];
+  string result;
+  snprintf(buf, sizeof buf, "iterations %" PRId64 "\n", iterations_);
+  result += buf;
+  snprintf(buf, sizeof buf, "poll %" PRId64 " us\n", pollMicros_);
+  result += buf;
+  snprintf(buf, sizeof buf, "channels %" PRId64 " callbacks %" PRId64 " us\n",
+           channelCallbacks_, channelMicros_);
+  result += buf;
+  snprintf(buf, sizeof buf, "timers %" PRId64 " callbacks %" PRId64 " us\n",
+           timerCallbacks_, timerMicros_);
+  result += buf;
+  snprintf(buf, sizeof buf, "functors %" PRId64 " in %" PRId64 " batches %" PRId64
+           " us, max batch %" PRId64 "\n",
+           functors_, functorBatches_, functorMicros_, maxPendingFunctors_);
+  result += buf;
+  if (slowestFd_ >= 0)
+  {
+    snprintf(buf, sizeof buf, "slowest callback %" PRId64 " us fd %d at %s\n",
+             slowestMicros_, slowestFd_,
+             Timestamp(slowestTime_).toFormattedString().c_str());
+    result += buf;
+  }
+  snprintf(buf, sizeof buf, "lag p50 < %" PRId64 " us p99 < %" PRId64
+           " us p99.9 < %" PRId64 " us\n",
+           lagPercentileMicros(50), lagPercentileMicros(99), lagPercentileMicros(99.9));
+  result += buf;
+  for (int i = 0; i < kLagBuckets; ++i)
+  {
+    if (lag_[i] > 0)
+    {
+      if (i < kLagBuckets-1)
+      {
+        snprintf(buf, sizeof buf, "  < %" PRId64 " us\t%" PRId64 "\n",
+                 static_cast<int64_t>(1) << i, lag_[i]);
+      }
+      else
+      {
+        snprintf(buf, sizeof buf, " >= %" PRId64 " us\t%" PRId64 "\n",
+                 static_cast<int64_t>(1) << (i-1), lag_[i]);
+      }
+      result += buf;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,92 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_LOOPSTATS_H
+#define MUDUO_NET_LOOPSTATS_H
+
+#include <muduo/base/Timestamp.h>
+#include <muduo/base/Types.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Where the time of an EventLoop goes, while EventLoop::setLoopStats() is on.
+///
+/// Only the loop thread writes it, with plain stores instead of locked
+/// instructions.  Other threads read it any time, and may see the
+/// current iteration half counted.
+class LoopStats : boost::noncopyable
+{
+ public:
+  /// Loop lag buckets: [0, 1us), [1us, 2us), [2us, 4us) ... the last
+  /// one takes the rest.
+  static const int kLagBuckets = 24;
+
+  LoopStats();
+
+  // in loop thread
+
+  void addPoll(int64_t micros);
+  void addChannel(int fd, bool timer, int64_t micros, Timestamp when);
+  void addFunctors(size_t count, int64_t micros);
+  /// @c busyMicros is from poll return to the next poll, the longest
+  /// that an event ready meanwhile waits for the loop.
+  void addIteration(int64_t busyMicros);
+
+  // in any thread
+
+  int64_t iterations() const { return iterations_; }
+  int64_t pollMicros() const { return pollMicros_; }
+  int64_t channelCallbacks() const { return channelCallbacks_; }
+  int64_t channelMicros() const { return channelMicros_; }
+  int64_t timerCallbacks() const { return timerCallbacks_; }
+  int64_t timerMicros() const { return timerMicros_; }
+  int64_t functors() const { return functors_; }
+  int64_t functorMicros() const { return functorMicros_; }
+  /// Most functors taken at once, ie. the deepest the queue got.
+  int64_t maxPendingFunctors() const { return maxPendingFunctors_; }
+  int64_t slowestCallbackMicros() const { return slowestMicros_; }
+  int slowestCallbackFd() const { return slowestFd_; }
+  int64_t lagCount(int bucket) const { return lag_[bucket]; }
+  /// Upper bound of the bucket holding @c percent of iterations.
+  int64_t lagPercentileMicros(double percent) const;
+
+  /// Multi-line text, eg. for Inspector.
+  string toString() const;
+
+ private:
+  volatile int64_t iterations_;
+  volatile int64_t pollMicros_;
+  volatile int64_t channelCallbacks_;
+  volatile int64_t channelMicros_;
+  volatile int64_t timerCallbacks_;
+  volatile int64_t timerMicros_;
+  volatile int64_t functors_;
+  volatile int64_t functorBatches_;
+  volatile int64_t functorMicros_;
+  volatile int64_t maxPendingFunctors_;
+  volatile int64_t slowestMicros_;
+  volatile int slowestFd_;
+  volatile int64_t slowestTime_;  // microseconds since epoch
+  volatile int64_t lag_[kLagBuckets];
+};
+
+}
+}
+
+#endif  // MUDUO_NET_LOOPSTATS_H
@@ -48,6 +48,9 @@ class Poller : boost::noncopyable
   /// Must be called in the loop thread.
   virtual void removeChannel(Channel* channel) = 0;
 
+  /// Whether Channel::setEdgeTriggered() works with this poller.
+  virtual bool supportsEdgeTriggered() const { return false; }
+
   static Poller* newDefaultPoller(EventLoop* loop);
 
   void assertInLoopThread()
@@ -55,6 +58,9 @@ class Poller : boost::noncopyable
     ownerLoop_->assertInLoopThread();
   }
 
+ protected:
+  EventLoop* ownerLoop() { return ownerLoop_; }
+
  private:
   EventLoop* ownerLoop_;
 };
@@ -0,0 +1,95 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/SlabAllocator.h>
+
+#include <assert.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t SlabAllocator::kAlignment;
+const size_t SlabAllocator::kMaxBlockSize;
+const size_t SlabAllocator::kChunkSize;
+
+SlabAllocator::SlabAllocator()
+  : cursor_(NULL),
+    end_(NULL),
+    inUse_(0)
+{
+  bzero(freeLists_, sizeof freeLists_);
+}
+
+SlabAllocator::~SlabAllocator()
+{
+  assert(inUse_ == 0);
+  for (size_t i = 0; i < chunks_.size(); ++i)
+  {
+    ::operator delete(chunks_[i]);
+  }
+}
+
+void* SlabAllocator::allocate(size_t size)
+{
+  if (size > kMaxBlockSize)
+  {
+    return ::operator new(size);
+  }
+
+  size_t index = sizeClass(size);
+  MutexLockGuard lock(mutex_);
+  ++inUse_;
+  FreeBlock* block = freeLists_[index];
+  if (block)
+  {
+    freeLists_[index] = block->next;
+    return block;
+  }
+
+  size_t blockSize = index * kAlignment;
+  if (cursor_ + blockSize > end_)
+  {
+    // the rest of the old chunk is left behind, at most kMaxBlockSize
+    cursor_ = static_cast<char*>(::operator new(kChunkSize));
+    end_ = cursor_ + kChunkSize;
+    chunks_.push_back(cursor_);
+  }
+  void* p = cursor_;
+  cursor_ += blockSize;
+  return p;
+}
+
+void SlabAllocator::deallocate(void* p, size_t size)
+{
+  if (size > kMaxBlockSize)
+  {
+    ::operator delete(p);
+    return;
+  }
+
+  FreeBlock* block = static_cast<FreeBlock*>(p);
+  size_t index = sizeClass(size);
+  MutexLockGuard lock(mutex_);
+  assert(inUse_ > 0);
+  --inUse_;
+  block->next = freeLists_[index];
+  freeLists_[index] = block;
+}
+
+size_t SlabAllocator::numBlocksInUse() const
+{
+  MutexLockGuard lock(mutex_);
+  return inUse_;
+}
+
+size_t SlabAllocator::bytesReserved() const
+{
+  MutexLockGuard lock(mutex_);
+  return chunks_.size() * kChunkSize;
+}
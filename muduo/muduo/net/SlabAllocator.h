@@ -0,0 +1,142 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_SLABALLOCATOR_H
+#define MUDUO_NET_SLABALLOCATOR_H
+
+#include <muduo/base/Mutex.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <new>
+#include <vector>
+
+#include <stddef.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Fixed size blocks carved from big chunks, one free list per size class.
+///
+/// Freed blocks are kept for the next allocation of the same size class,
+/// memory goes back to the system only when the allocator dies.
+/// Blocks may be freed in any thread.
+class SlabAllocator : boost::noncopyable
+{
+ public:
+  static const size_t kAlignment = 16;
+  static const size_t kMaxBlockSize = 2048;  // bigger ones go to operator new
+  static const size_t kChunkSize = 64*1024;
+
+  SlabAllocator();
+  ~SlabAllocator();
+
+  void* allocate(size_t size);
+  void deallocate(void* p, size_t size);
+
+  /// blocks handed out and not freed yet
+  size_t numBlocksInUse() const;
+  /// bytes reserved from the system
+  size_t bytesReserved() const;
+
+ private:
+  struct FreeBlock
+  {
+    FreeBlock* next;
+  };
+
+  // 0 bytes get the smallest block, a unique pointer like operator new
+  static size_t sizeClass(size_t size)
+  { return size == 0 ? 1 : (size + kAlignment - 1) / kAlignment; }
+
+  mutable MutexLock mutex_;
+  FreeBlock* freeLists_[kMaxBlockSize / kAlignment + 1];
+  std::vector<char*> chunks_;
+  char* cursor_;
+  char* end_;
+  size_t inUse_;
+};
+
+///
+/// STL allocator on top of a shared SlabAllocator, for boost::allocate_shared.
+///
+/// Every copy holds the SlabAllocator, so blocks can be freed safely
+/// after the EventLoop that owns it is gone.
+template<typename T>
+class LoopAllocator
+{
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template<typename U>
+  struct rebind
+  {
+    typedef LoopAllocator<U> other;
+  };
+
+  explicit LoopAllocator(const boost::shared_ptr<SlabAllocator>& slab)
+    : slab_(slab)
+  {
+  }
+
+  template<typename U>
+  LoopAllocator(const LoopAllocator<U>& rhs)
+    : slab_(rhs.slab())
+  {
+  }
+
+  pointer allocate(size_type n, const void* = 0)
+  { return static_cast<pointer>(slab_->allocate(n * sizeof(T))); }
+
+  void deallocate(pointer p, size_type n)
+  { slab_->deallocate(p, n * sizeof(T)); }
+
+  void construct(pointer p, const T& value)
+  { new (p) T(value); }
+
+  void destroy(pointer p)
+  { p->~T(); }
+
+  pointer address(reference x) const { return &x; }
+  const_pointer address(const_reference x) const { return &x; }
+  size_type max_size() const { return static_cast<size_type>(-1) / sizeof(T); }
+
+  const boost::shared_ptr<SlabAllocator>& slab() const { return slab_; }
+
+ private:
+  boost::shared_ptr<SlabAllocator> slab_;
+};
+
+template<typename T, typename U>
+bool operator==(const LoopAllocator<T>& lhs, const LoopAllocator<U>& rhs)
+{
+  return lhs.slab() == rhs.slab();
+}
+
+template<typename T, typename U>
+bool operator!=(const LoopAllocator<T>& lhs, const LoopAllocator<U>& rhs)
+{
+  return lhs.slab() != rhs.slab();
+}
+
+}
+}
+
+#endif  // MUDUO_NET_SLABALLOCATOR_H
@@ -8,6 +8,7 @@
 
 #include <muduo/net/Socket.h>
 
+#include <muduo/base/Logging.h>
 #include <muduo/net/InetAddress.h>
 #include <muduo/net/SocketsOps.h>
 
@@ -25,7 +26,7 @@ Socket::~Socket()
 
 void Socket::bindAddress(const InetAddress& addr)
 {
-  sockets::bindOrDie(sockfd_, addr.getSockAddrInet());
+  sockets::bindOrDie(sockfd_, addr.getSockAddr(), addr.getSockLen());
 }
 
 void Socket::listen()
@@ -35,12 +36,12 @@ void Socket::listen()
 
 int Socket::accept(InetAddress* peeraddr)
 {
-  struct sockaddr_in addr;
+  struct sockaddr_storage addr;
   bzero(&addr, sizeof addr);
   int connfd = sockets::accept(sockfd_, &addr);
   if (connfd >= 0)
   {
-    peeraddr->setSockAddrInet(addr);
+    *peeraddr = InetAddress(addr);
   }
   return connfd;
 }
@@ -58,6 +59,24 @@ void Socket::setTcpNoDelay(bool on)
   // FIXME CHECK
 }
 
+void Socket::setReusePort(bool on)
+{
+#ifdef SO_REUSEPORT
+  int optval = on ? 1 : 0;
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT,
+                         &optval, sizeof optval);
+  if (ret < 0 && on)
+  {
+    LOG_SYSERR << "SO_REUSEPORT failed.";
+  }
+#else
+  if (on)
+  {
+    LOG_ERROR << "SO_REUSEPORT is not supported.";
+  }
+#endif
+}
+
 void Socket::setReuseAddr(bool on)
 {
   int optval = on ? 1 : 0;
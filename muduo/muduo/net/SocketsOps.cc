@@ -15,8 +15,12 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>  // snprintf
+#include <string.h>  // memcmp
 #include <strings.h>  // bzero
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/uio.h>  // readv, writev
+#include <sys/un.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -27,12 +31,7 @@ namespace
 
 typedef struct sockaddr SA;
 
-const SA* sockaddr_cast(const struct sockaddr_in* addr)
-{
-  return static_cast<const SA*>(implicit_cast<const void*>(addr));
-}
-
-SA* sockaddr_cast(struct sockaddr_in* addr)
+SA* sockaddr_cast(struct sockaddr_storage* addr)
 {
   return static_cast<SA*>(implicit_cast<void*>(addr));
 }
@@ -56,11 +55,11 @@ void setNonBlockAndCloseOnExec(int sockfd)
 
 }
 
-int sockets::createNonblockingOrDie()
+int sockets::createNonblockingOrDie(sa_family_t family)
 {
-  // socket
+  // socket, IPPROTO_TCP is wrong for AF_UNIX, 0 picks the default
 #if VALGRIND
-  int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM, 0);
   if (sockfd < 0)
   {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -68,7 +67,7 @@ int sockets::createNonblockingOrDie()
 
   setNonBlockAndCloseOnExec(sockfd);
 #else
-  int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
   if (sockfd < 0)
   {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -77,9 +76,29 @@ int sockets::createNonblockingOrDie()
   return sockfd;
 }
 
-void sockets::bindOrDie(int sockfd, const struct sockaddr_in& addr)
+int sockets::createNonblockingUdpOrDie(sa_family_t family)
 {
-  int ret = ::bind(sockfd, sockaddr_cast(&addr), sizeof addr);
+#if VALGRIND
+  int sockfd = ::socket(family, SOCK_DGRAM, 0);
+  if (sockfd < 0)
+  {
+    LOG_SYSFATAL << "sockets::createNonblockingUdpOrDie";
+  }
+
+  setNonBlockAndCloseOnExec(sockfd);
+#else
+  int sockfd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sockfd < 0)
+  {
+    LOG_SYSFATAL << "sockets::createNonblockingUdpOrDie";
+  }
+#endif
+  return sockfd;
+}
+
+void sockets::bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
+{
+  int ret = ::bind(sockfd, addr, addrlen);
   if (ret < 0)
   {
     LOG_SYSFATAL << "sockets::bindOrDie";
@@ -95,9 +114,9 @@ void sockets::listenOrDie(int sockfd)
   }
 }
 
-int sockets::accept(int sockfd, struct sockaddr_in* addr)
+int sockets::accept(int sockfd, struct sockaddr_storage* addr)
 {
-  socklen_t addrlen = sizeof *addr;
+  socklen_t addrlen = static_cast<socklen_t>(sizeof *addr);
 #if VALGRIND
   int connfd = ::accept(sockfd, sockaddr_cast(addr), &addrlen);
   setNonBlockAndCloseOnExec(connfd);
@@ -108,7 +127,10 @@ int sockets::accept(int sockfd, struct sockaddr_in* addr)
   if (connfd < 0)
   {
     int savedErrno = errno;
-    LOG_SYSERR << "Socket::accept";
+    if (savedErrno != EAGAIN)  // Acceptor may drain the backlog until EAGAIN
+    {
+      LOG_SYSERR << "Socket::accept";
+    }
     switch (savedErrno)
     {
       case EAGAIN:
@@ -139,9 +161,9 @@ int sockets::accept(int sockfd, struct sockaddr_in* addr)
   return connfd;
 }
 
-int sockets::connect(int sockfd, const struct sockaddr_in& addr)
+int sockets::connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
 {
-  return ::connect(sockfd, sockaddr_cast(&addr), sizeof addr);
+  return ::connect(sockfd, addr, addrlen);
 }
 
 ssize_t sockets::read(int sockfd, void *buf, size_t count)
@@ -159,6 +181,26 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count)
   return ::write(sockfd, buf, count);
 }
 
+ssize_t sockets::writev(int sockfd, const struct iovec *iov, int iovcnt)
+{
+  return ::writev(sockfd, iov, iovcnt);
+}
+
+ssize_t sockets::sendfile(int sockfd, int fd, off_t offset, size_t count)
+{
+  return ::sendfile(sockfd, fd, &offset, count);
+}
+
+int sockets::recvmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen)
+{
+  return ::recvmmsg(sockfd, msgvec, vlen, 0, NULL);
+}
+
+int sockets::sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen)
+{
+  return ::sendmmsg(sockfd, msgvec, vlen, 0);
+}
+
 void sockets::close(int sockfd)
 {
   if (::close(sockfd) < 0)
@@ -176,19 +218,52 @@ void sockets::shutdownWrite(int sockfd)
 }
 
 void sockets::toIpPort(char* buf, size_t size,
-                       const struct sockaddr_in& addr)
+                       const struct sockaddr* addr)
 {
-  char host[INET_ADDRSTRLEN] = "INVALID";
+  if (addr->sa_family == AF_UNIX)
+  {
+    toIp(buf, size, addr);
+    return;
+  }
+  char host[INET6_ADDRSTRLEN] = "INVALID";
   toIp(host, sizeof host, addr);
-  uint16_t port = sockets::networkToHost16(addr.sin_port);
-  snprintf(buf, size, "%s:%u", host, port);
+  // sin_port and sin6_port are at the same offset
+  const struct sockaddr_in* addr4 =
+    static_cast<const struct sockaddr_in*>(implicit_cast<const void*>(addr));
+  uint16_t port = sockets::networkToHost16(addr4->sin_port);
+  if (addr->sa_family == AF_INET6)
+  {
+    snprintf(buf, size, "[%s]:%u", host, port);
+  }
+  else
+  {
+    snprintf(buf, size, "%s:%u", host, port);
+  }
 }
 
 void sockets::toIp(char* buf, size_t size,
-                   const struct sockaddr_in& addr)
+                   const struct sockaddr* addr)
 {
-  assert(size >= INET_ADDRSTRLEN);
-  ::inet_ntop(AF_INET, &addr.sin_addr, buf, static_cast<socklen_t>(size));
+  if (addr->sa_family == AF_INET6)
+  {
+    assert(size >= INET6_ADDRSTRLEN);
+    const struct sockaddr_in6* addr6 =
+      static_cast<const struct sockaddr_in6*>(implicit_cast<const void*>(addr));
+    ::inet_ntop(AF_INET6, &addr6->sin6_addr, buf, static_cast<socklen_t>(size));
+  }
+  else if (addr->sa_family == AF_UNIX)
+  {
+    const struct sockaddr_un* addrUn =
+      static_cast<const struct sockaddr_un*>(implicit_cast<const void*>(addr));
+    snprintf(buf, size, "%.*s", static_cast<int>(sizeof addrUn->sun_path), addrUn->sun_path);
+  }
+  else
+  {
+    assert(size >= INET_ADDRSTRLEN);
+    const struct sockaddr_in* addr4 =
+      static_cast<const struct sockaddr_in*>(implicit_cast<const void*>(addr));
+    ::inet_ntop(AF_INET, &addr4->sin_addr, buf, static_cast<socklen_t>(size));
+  }
 }
 
 void sockets::fromIpPort(const char* ip, uint16_t port,
@@ -202,6 +277,17 @@ void sockets::fromIpPort(const char* ip, uint16_t port,
   }
 }
 
+void sockets::fromIpPort(const char* ip, uint16_t port,
+                           struct sockaddr_in6* addr)
+{
+  addr->sin6_family = AF_INET6;
+  addr->sin6_port = hostToNetwork16(port);
+  if (::inet_pton(AF_INET6, ip, &addr->sin6_addr) <= 0)
+  {
+    LOG_SYSERR << "sockets::fromIpPort";
+  }
+}
+
 int sockets::getSocketError(int sockfd)
 {
   int optval;
@@ -217,11 +303,11 @@ int sockets::getSocketError(int sockfd)
   }
 }
 
-struct sockaddr_in sockets::getLocalAddr(int sockfd)
+struct sockaddr_storage sockets::getLocalAddr(int sockfd)
 {
-  struct sockaddr_in localaddr;
+  struct sockaddr_storage localaddr;
   bzero(&localaddr, sizeof localaddr);
-  socklen_t addrlen = sizeof(localaddr);
+  socklen_t addrlen = static_cast<socklen_t>(sizeof localaddr);
   if (::getsockname(sockfd, sockaddr_cast(&localaddr), &addrlen) < 0)
   {
     LOG_SYSERR << "sockets::getLocalAddr";
@@ -229,11 +315,11 @@ struct sockaddr_in sockets::getLocalAddr(int sockfd)
   return localaddr;
 }
 
-struct sockaddr_in sockets::getPeerAddr(int sockfd)
+struct sockaddr_storage sockets::getPeerAddr(int sockfd)
 {
-  struct sockaddr_in peeraddr;
+  struct sockaddr_storage peeraddr;
   bzero(&peeraddr, sizeof peeraddr);
-  socklen_t addrlen = sizeof(peeraddr);
+  socklen_t addrlen = static_cast<socklen_t>(sizeof peeraddr);
   if (::getpeername(sockfd, sockaddr_cast(&peeraddr), &addrlen) < 0)
   {
     LOG_SYSERR << "sockets::getPeerAddr";
@@ -243,9 +329,25 @@ struct sockaddr_in sockets::getPeerAddr(int sockfd)
 
 bool sockets::isSelfConnect(int sockfd)
 {
-  struct sockaddr_in localaddr = getLocalAddr(sockfd);
-  struct sockaddr_in peeraddr = getPeerAddr(sockfd);
-  return localaddr.sin_port == peeraddr.sin_port
-      && localaddr.sin_addr.s_addr == peeraddr.sin_addr.s_addr;
+  struct sockaddr_storage localaddr = getLocalAddr(sockfd);
+  struct sockaddr_storage peeraddr = getPeerAddr(sockfd);
+  if (localaddr.ss_family == AF_INET)
+  {
+    const struct sockaddr_in* laddr4 = reinterpret_cast<struct sockaddr_in*>(&localaddr);
+    const struct sockaddr_in* raddr4 = reinterpret_cast<struct sockaddr_in*>(&peeraddr);
+    return laddr4->sin_port == raddr4->sin_port
+        && laddr4->sin_addr.s_addr == raddr4->sin_addr.s_addr;
+  }
+  else if (localaddr.ss_family == AF_INET6)
+  {
+    const struct sockaddr_in6* laddr6 = reinterpret_cast<struct sockaddr_in6*>(&localaddr);
+    const struct sockaddr_in6* raddr6 = reinterpret_cast<struct sockaddr_in6*>(&peeraddr);
+    return laddr6->sin6_port == raddr6->sin6_port
+        && memcmp(&laddr6->sin6_addr, &raddr6->sin6_addr, sizeof laddr6->sin6_addr) == 0;
+  }
+  else
+  {
+    // a Unix-domain client has no name of its own
+    return false;
+  }
 }
-
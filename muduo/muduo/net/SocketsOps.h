@@ -13,6 +13,8 @@
 
 #include <arpa/inet.h>
 
+struct mmsghdr;
+
 namespace muduo
 {
 namespace net
@@ -23,29 +25,39 @@ namespace sockets
 ///
 /// Creates a non-blocking socket file descriptor,
 /// abort if any error.
-int createNonblockingOrDie();
+int createNonblockingOrDie(sa_family_t family = AF_INET);
+/// Same for a UDP socket.
+int createNonblockingUdpOrDie(sa_family_t family = AF_INET);
 
-int  connect(int sockfd, const struct sockaddr_in& addr);
-void bindOrDie(int sockfd, const struct sockaddr_in& addr);
+int  connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
+void bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 void listenOrDie(int sockfd);
-int  accept(int sockfd, struct sockaddr_in* addr);
+int  accept(int sockfd, struct sockaddr_storage* addr);
 ssize_t read(int sockfd, void *buf, size_t count);
 ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 ssize_t write(int sockfd, const void *buf, size_t count);
+ssize_t writev(int sockfd, const struct iovec *iov, int iovcnt);
+/// Sends [offset, offset+count) of file fd, doesn't change its file offset.
+ssize_t sendfile(int sockfd, int fd, off_t offset, size_t count);
+int recvmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen);
+int sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen);
 void close(int sockfd);
 void shutdownWrite(int sockfd);
 
+/// Path only for Unix-domain.
 void toIpPort(char* buf, size_t size,
-              const struct sockaddr_in& addr);
+              const struct sockaddr* addr);
 void toIp(char* buf, size_t size,
-          const struct sockaddr_in& addr);
+          const struct sockaddr* addr);
 void fromIpPort(const char* ip, uint16_t port,
                   struct sockaddr_in* addr);
+void fromIpPort(const char* ip, uint16_t port,
+                  struct sockaddr_in6* addr);
 
 int getSocketError(int sockfd);
 
-struct sockaddr_in getLocalAddr(int sockfd);
-struct sockaddr_in getPeerAddr(int sockfd);
+struct sockaddr_storage getLocalAddr(int sockfd);
+struct sockaddr_storage getPeerAddr(int sockfd);
 bool isSelfConnect(int sockfd);
 
 }
@@ -0,0 +1,89 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/SplicePipe.h>
+
+#include <muduo/base/Logging.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int SplicePipe::kPipeSize;
+
+SplicePipe::SplicePipe()
+  : readFd_(-1),
+    writeFd_(-1),
+    capacity_(0),
+    readableBytes_(0)
+{
+  int fds[2];
+  if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0)
+  {
+    LOG_SYSFATAL << "SplicePipe::SplicePipe";
+  }
+  readFd_ = fds[0];
+  writeFd_ = fds[1];
+  // may fail for unprivileged users over /proc/sys/fs/pipe-max-size
+  ::fcntl(writeFd_, F_SETPIPE_SZ, kPipeSize);
+  int size = ::fcntl(writeFd_, F_GETPIPE_SZ);
+  capacity_ = size > 0 ? size : 64*1024;
+}
+
+SplicePipe::~SplicePipe()
+{
+  ::close(readFd_);
+  ::close(writeFd_);
+}
+
+ssize_t SplicePipe::spliceFrom(int fd, int* savedErrno)
+{
+  ssize_t n = ::splice(fd, NULL, writeFd_, NULL, writableBytes(),
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else
+  {
+    readableBytes_ += n;
+  }
+  return n;
+}
+
+ssize_t SplicePipe::spliceTo(int fd, int* savedErrno)
+{
+  ssize_t n = ::splice(readFd_, NULL, fd, NULL, readableBytes_,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else
+  {
+    readableBytes_ -= n;
+  }
+  return n;
+}
+
+void SplicePipe::discardAll()
+{
+  char buf[4096];
+  while (readableBytes_ > 0)
+  {
+    ssize_t n = ::read(readFd_, buf, sizeof buf);
+    if (n <= 0)
+    {
+      break;
+    }
+    readableBytes_ -= n;
+  }
+}
@@ -0,0 +1,61 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_SPLICEPIPE_H
+#define MUDUO_NET_SPLICEPIPE_H
+
+#include <boost/noncopyable.hpp>
+
+#include <sys/types.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// A pipe that moves bytes from one socket to another with splice(2),
+/// pages are passed by reference and never copied to user space.
+///
+/// Counts the bytes it holds, capacity is the size of the pipe.
+class SplicePipe : boost::noncopyable
+{
+ public:
+  /// asked for with F_SETPIPE_SZ, the kernel may give less
+  static const int kPipeSize = 256*1024;
+
+  SplicePipe();
+  ~SplicePipe();
+
+  size_t readableBytes() const { return readableBytes_; }
+  size_t writableBytes() const { return capacity_ - readableBytes_; }
+
+  /// Moves up to writableBytes() from socket @c fd into the pipe.
+  /// @return result of splice(2), @c errno is saved
+  ssize_t spliceFrom(int fd, int* savedErrno);
+
+  /// Moves what the pipe holds to socket @c fd.
+  /// @return result of splice(2), @c errno is saved
+  ssize_t spliceTo(int fd, int* savedErrno);
+
+  /// Throws away what the pipe holds, eg. when the sink is gone.
+  void discardAll();
+
+ private:
+  int readFd_;
+  int writeFd_;
+  size_t capacity_;
+  size_t readableBytes_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_SPLICEPIPE_H
@@ -12,9 +12,11 @@
 #include <muduo/base/Logging.h>
 #include <muduo/net/Connector.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/SlabAllocator.h>
 #include <muduo/net/SocketsOps.h>
 
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 
 #include <stdio.h>  // snprintf
 
@@ -63,6 +65,7 @@ TcpClient::TcpClient(EventLoop* loop,
     messageCallback_(defaultMessageCallback),
     retry_(false),
     connect_(true),
+    edgeTriggered_(false),
     nextConnId_(1)
 {
   connector_->setNewConnectionCallback(
@@ -128,25 +131,28 @@ void TcpClient::newConnection(int sockfd)
 {
   loop_->assertInLoopThread();
   InetAddress peerAddr(sockets::getPeerAddr(sockfd));
+  // the peer may be a long IPv6 address or Unix-domain path
   char buf[32];
-  snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
+  snprintf(buf, sizeof buf, "#%d", nextConnId_);
   ++nextConnId_;
-  string connName = name_ + buf;
+  string connName = name_ + ":" + peerAddr.toIpPort() + buf;
 
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
-  // FIXME use make_shared if necessary
-  TcpConnectionPtr conn(new TcpConnection(loop_,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));
+  // TcpConnection and its reference count share a block of the loop's slab
+  TcpConnectionPtr conn(boost::allocate_shared<TcpConnection>(
+        LoopAllocator<TcpConnection>(loop_->slabAllocator()),
+        loop_, connName, sockfd, localAddr, peerAddr));
 
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
   conn->setCloseCallback(
       boost::bind(&TcpClient::removeConnection, this, _1)); // FIXME: unsafe
+  if (edgeTriggered_)
+  {
+    conn->setEdgeTriggered(true);
+  }
   {
     MutexLockGuard lock(mutex_);
     connection_ = conn;
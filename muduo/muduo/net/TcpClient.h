@@ -47,6 +47,10 @@ class TcpClient : boost::noncopyable
   bool retry() const;
   void enableRetry() { retry_ = true; }
 
+  /// Registers the connection edge-triggered, if the poller supports it.
+  /// Not thread safe.
+  void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
   /// Set connection callback.
   /// Not thread safe.
   void setConnectionCallback(const ConnectionCallback& cb)
@@ -76,6 +80,7 @@ class TcpClient : boost::noncopyable
   WriteCompleteCallback writeCompleteCallback_;
   bool retry_;   // atmoic
   bool connect_; // atomic
+  bool edgeTriggered_;
   // always in loop thread
   int nextConnId_;
   mutable MutexLock mutex_;
@@ -9,19 +9,36 @@
 #include <muduo/net/TcpConnection.h>
 
 #include <muduo/base/Logging.h>
+#include <muduo/net/BufferPool.h>
 #include <muduo/net/Channel.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/SlabAllocator.h>
 #include <muduo/net/Socket.h>
 #include <muduo/net/SocketsOps.h>
+#include <muduo/net/SplicePipe.h>
 
 #include <boost/bind.hpp>
 
 #include <errno.h>
+#include <poll.h>
 #include <stdio.h>
+#include <sys/socket.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+struct TcpConnection::SocketChannel
+{
+  SocketChannel(EventLoop* loop, int sockfd)
+    : socket(sockfd),
+      channel(loop, sockfd)
+  {
+  }
+
+  Socket socket;
+  Channel channel;
+};
+
 void muduo::net::defaultConnectionCallback(const TcpConnectionPtr& conn)
 {
   LOG_TRACE << conn->localAddress().toIpPort() << " -> "
@@ -42,14 +59,27 @@ TcpConnection::TcpConnection(EventLoop* loop,
                              const InetAddress& localAddr,
                              const InetAddress& peerAddr)
   : loop_(CHECK_NOTNULL(loop)),
+    loopLoad_(loop->loadGauge()),
+    loopGauge_(loop->connectionGauge()),
+    slabAllocator_(loop->slabAllocator()),
     name_(nameArg),
     state_(kConnecting),
-    socket_(new Socket(sockfd)),
-    channel_(new Channel(loop, sockfd)),
+    io_(new (slabAllocator_->allocate(sizeof(SocketChannel)))
+        SocketChannel(loop_, sockfd)),
+    socket_(&io_->socket),
+    channel_(&io_->channel),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    highWaterMark_(64*1024*1024),
+    inputHighWaterMark_(0),
+    reading_(true),
+    reportedOutputBytes_(0),
+    pooledBuffers_(false),
+    reportedInputBytes_(0),
+    creationTime_(Timestamp::now())
 {
+  bzero(&stats_, sizeof stats_);
+  bzero(&reportedStats_, sizeof reportedStats_);
   channel_->setReadCallback(
       boost::bind(&TcpConnection::handleRead, this, _1));
   channel_->setWriteCallback(
@@ -61,12 +91,22 @@ TcpConnection::TcpConnection(EventLoop* loop,
   LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
             << " fd=" << sockfd;
   socket_->setKeepAlive(true);
+  loopLoad_->connections.increment();
 }
 
 TcpConnection::~TcpConnection()
 {
   LOG_DEBUG << "TcpConnection::dtor[" <<  name_ << "] at " << this
             << " fd=" << channel_->fd();
+  loopLoad_->connections.decrement();
+  loopLoad_->pendingOutputBytes.add(-static_cast<int64_t>(reportedOutputBytes_));
+  if (bufferGauge_)
+  {
+    bufferGauge_->inputBytes.add(-static_cast<int64_t>(reportedInputBytes_));
+    bufferGauge_->outputBytes.add(-static_cast<int64_t>(reportedOutputBytes_));
+  }
+  io_->~SocketChannel();
+  slabAllocator_->deallocate(io_, sizeof(SocketChannel));
 }
 
 void TcpConnection::send(const void* data, size_t len)
@@ -79,11 +119,14 @@ void TcpConnection::send(const void* data, size_t len)
     }
     else
     {
-      string message(static_cast<const char*>(data), len);
+      boost::shared_ptr<string> message(
+          new string(static_cast<const char*>(data), len));
       loop_->runInLoop(
-          boost::bind(&TcpConnection::sendInLoop,
+          boost::bind(&TcpConnection::sendSharedInLoop,
                       this,     // FIXME
-                      message));
+                      message,
+                      message->data(),
+                      message->size()));
     }
   }
 }
@@ -98,32 +141,97 @@ void TcpConnection::send(const StringPiece& message)
     }
     else
     {
+      // copy once, then pass it around by reference count
+      boost::shared_ptr<string> copy(new string(message.as_string()));
       loop_->runInLoop(
-          boost::bind(&TcpConnection::sendInLoop,
+          boost::bind(&TcpConnection::sendSharedInLoop,
                       this,     // FIXME
-                      message.as_string()));
+                      copy,
+                      copy->data(),
+                      copy->size()));
                     //std::forward<string>(message)));
     }
   }
 }
 
-// FIXME efficiency!!!
 void TcpConnection::send(Buffer* buf)
 {
   if (state_ == kConnected)
   {
     if (loop_->isInLoopThread())
     {
-      sendInLoop(buf->peek(), buf->readableBytes());
-      buf->retrieveAll();
+      sendInLoop(buf);
     }
     else
     {
+      boost::shared_ptr<Buffer> message(new Buffer);
+      message->swap(*buf);
       loop_->runInLoop(
-          boost::bind(&TcpConnection::sendInLoop,
+          boost::bind(&TcpConnection::sendSharedInLoop,
                       this,     // FIXME
-                      buf->retrieveAllAsString()));
-                    //std::forward<string>(message)));
+                      message,
+                      message->peek(),
+                      message->readableBytes()));
+    }
+  }
+}
+
+void TcpConnection::send(const PayloadPtr& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendSharedInLoop(message, message->data(), message->size());
+    }
+    else
+    {
+      loop_->runInLoop(
+          boost::bind(&TcpConnection::sendSharedInLoop,
+                      this,     // FIXME
+                      message,
+                      message->data(),
+                      message->size()));
+    }
+  }
+}
+
+void TcpConnection::send(BufferChain* chain)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendInLoop(chain);
+    }
+    else
+    {
+      boost::shared_ptr<BufferChain> message(new BufferChain);
+      message->append(chain);
+      loop_->runInLoop(
+          boost::bind(&TcpConnection::sendChainInLoop,
+                      this,     // FIXME
+                      message));
+    }
+  }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t len)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendFileInLoop(fd, offset, len);
+    }
+    else
+    {
+      loop_->runInLoop(
+          boost::bind(&TcpConnection::sendFileInLoop,
+                      this,     // FIXME
+                      fd,
+                      offset,
+                      len));
     }
   }
 }
@@ -136,22 +244,204 @@ void TcpConnection::sendInLoop(const StringPiece& message)
 void TcpConnection::sendInLoop(const void* data, size_t len)
 {
   loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  ssize_t nwrote = trySendDirectly(data, len);
+  if (nwrote >= 0 && implicit_cast<size_t>(nwrote) < len)
+  {
+    LOG_TRACE << "I am going to write more data";
+    size_t oldLen = outputBytesInMemory();
+    outputBuffer_.append(static_cast<const char*>(data)+nwrote, len-nwrote);
+    outputQueued(oldLen);
+  }
+}
+
+void TcpConnection::sendInLoop(Buffer* buf)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    buf->retrieveAll();
+    return;
+  }
+  ssize_t nwrote = trySendDirectly(buf->peek(), buf->readableBytes());
+  if (nwrote < 0)
+  {
+    buf->retrieveAll();
+  }
+  else
+  {
+    buf->retrieve(nwrote);
+    if (buf->readableBytes() > 0)
+    {
+      LOG_TRACE << "I am going to write more data";
+      size_t oldLen = outputBytesInMemory();
+      outputBuffer_.append(buf);  // large buffers are swapped in, not copied
+      outputQueued(oldLen);
+    }
+  }
+}
+
+void TcpConnection::sendChainInLoop(const boost::shared_ptr<BufferChain>& chain)
+{
+  sendInLoop(get_pointer(chain));
+}
+
+void TcpConnection::sendInLoop(BufferChain* chain)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    chain->retrieveAll();
+    return;
+  }
+  const size_t len = chain->readableBytes();
+  if (len == 0)
+  {
+    return;
+  }
+  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+  {
+    // the whole frame in one writev(2)
+    int savedErrno = 0;
+    ssize_t nwrote = chain->writeFd(channel_->fd(), &savedErrno);
+    countWrite(nwrote);
+    reportStats();
+    if (nwrote < 0)
+    {
+      if (savedErrno != EWOULDBLOCK)
+      {
+        errno = savedErrno;
+        LOG_SYSERR << "TcpConnection::sendInLoop";
+        if (savedErrno == EPIPE) // FIXME: any others?
+        {
+          chain->retrieveAll();
+          return;
+        }
+      }
+    }
+    else if (implicit_cast<size_t>(nwrote) == len && writeCompleteCallback_)
+    {
+      loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+    }
+  }
+  if (chain->readableBytes() > 0)
+  {
+    LOG_TRACE << "I am going to write more data";
+    size_t oldLen = outputBytesInMemory();
+    outputBuffer_.append(chain);  // slices are moved, not copied
+    outputQueued(oldLen);
+  }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t len)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  if (len == 0)
+  {
+    return;
+  }
   ssize_t nwrote = 0;
-  size_t remaining = len;
-  bool error = false;
+  // if no thing in output queue, try sending directly
+  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+  {
+    nwrote = sockets::sendfile(channel_->fd(), fd, offset, len);
+    countWrite(nwrote);
+    reportStats();
+    if (nwrote == 0)
+    {
+      LOG_ERROR << "TcpConnection::sendFileInLoop [" << name_
+                << "] - offset " << offset << " is beyond end of file";
+      abortOutput();
+      return;
+    }
+    else if (nwrote > 0)
+    {
+      if (implicit_cast<size_t>(nwrote) == len && writeCompleteCallback_)
+      {
+        loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+      }
+    }
+    else // nwrote < 0
+    {
+      nwrote = 0;
+      if (errno != EWOULDBLOCK)
+      {
+        LOG_SYSERR << "TcpConnection::sendFileInLoop";
+        if (errno == EPIPE) // FIXME: any others?
+        {
+          return;
+        }
+      }
+    }
+  }
+  if (implicit_cast<size_t>(nwrote) < len)
+  {
+    LOG_TRACE << "I am going to write more data";
+    size_t oldLen = outputBytesInMemory();
+    outputBuffer_.appendFile(fd, offset + nwrote, len - nwrote);
+    outputQueued(oldLen);
+  }
+}
+
+void TcpConnection::spliceTo(const TcpConnectionPtr& sink)
+{
+  loop_->assertInLoopThread();
+  assert(sink->getLoop() == loop_);
+  assert(!relayOut_ && !sink->relayIn_);
+  // bytes read before go first, relayed ones queue behind them
+  if (inputBuffer_.readableBytes() > 0)
+  {
+    sink->sendInLoop(&inputBuffer_);
+  }
+  relayOut_.reset(new SplicePipe);
+  relaySink_ = sink;
+  sink->relayIn_ = relayOut_;
+  sink->relaySource_ = shared_from_this();
+}
+
+void TcpConnection::sendSharedInLoop(const boost::shared_ptr<const void>& holder,
+                                     const char* data,
+                                     size_t len)
+{
+  loop_->assertInLoopThread();
   if (state_ == kDisconnected)
   {
     LOG_WARN << "disconnected, give up writing";
     return;
   }
+  ssize_t nwrote = trySendDirectly(data, len);
+  if (nwrote >= 0 && implicit_cast<size_t>(nwrote) < len)
+  {
+    LOG_TRACE << "I am going to write more data";
+    size_t oldLen = outputBytesInMemory();
+    outputBuffer_.append(holder, data+nwrote, len-nwrote);
+    outputQueued(oldLen);
+  }
+}
+
+ssize_t TcpConnection::trySendDirectly(const void* data, size_t len)
+{
+  ssize_t nwrote = 0;
   // if no thing in output queue, try writing directly
   if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
   {
     nwrote = sockets::write(channel_->fd(), data, len);
+    countWrite(nwrote);
+    reportStats();
     if (nwrote >= 0)
     {
-      remaining = len - nwrote;
-      if (remaining == 0 && writeCompleteCallback_)
+      if (implicit_cast<size_t>(nwrote) == len && writeCompleteCallback_)
       {
         loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
       }
@@ -164,31 +454,96 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         LOG_SYSERR << "TcpConnection::sendInLoop";
         if (errno == EPIPE) // FIXME: any others?
         {
-          error = true;
+          nwrote = -1;
         }
       }
     }
   }
+  assert(nwrote < 0 || implicit_cast<size_t>(nwrote) <= len);
+  return nwrote;
+}
 
-  assert(remaining <= len);
-  if (!error && remaining > 0)
+void TcpConnection::outputQueued(size_t oldLen)
+{
+  updatePendingOutputBytes();
+  size_t newLen = outputBytesInMemory();
+  if (newLen >= highWaterMark_
+      && oldLen < highWaterMark_
+      && highWaterMarkCallback_)
   {
-    LOG_TRACE << "I am going to write more data";
-    size_t oldLen = outputBuffer_.readableBytes();
-    if (oldLen + remaining >= highWaterMark_
-        && oldLen < highWaterMark_
-        && highWaterMarkCallback_)
-    {
-      loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
-    }
-    outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
-    if (!channel_->isWriting())
+    loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(), newLen));
+  }
+  if (!channel_->isWriting())
+  {
+    channel_->enableWriting();
+  }
+}
+
+void TcpConnection::updatePendingOutputBytes()
+{
+  size_t len = outputBytesInMemory();
+  if (len != reportedOutputBytes_)
+  {
+    int64_t delta = static_cast<int64_t>(len) - static_cast<int64_t>(reportedOutputBytes_);
+    loopLoad_->pendingOutputBytes.add(delta);
+    if (bufferGauge_)
     {
-      channel_->enableWriting();
+      bufferGauge_->outputBytes.add(delta);
     }
+    reportedOutputBytes_ = len;
+  }
+}
+
+void TcpConnection::updateInputBytes()
+{
+  size_t len = inputBuffer_.internalCapacity();
+  if (bufferGauge_ && len != reportedInputBytes_)
+  {
+    bufferGauge_->inputBytes.add(static_cast<int64_t>(len)
+                                 - static_cast<int64_t>(reportedInputBytes_));
+    reportedInputBytes_ = len;
   }
 }
 
+void TcpConnection::countRead(ssize_t n)
+{
+  ++loop_->syscallStats().reads;
+  ++stats_.reads;
+  if (n > 0)
+  {
+    stats_.bytesReceived += n;
+    lastReceiveTime_ = loop_->pollReturnTime();
+  }
+}
+
+void TcpConnection::countWrite(ssize_t n)
+{
+  ++loop_->syscallStats().writes;
+  ++stats_.writes;
+  if (n > 0)
+  {
+    stats_.bytesSent += n;
+    lastSendTime_ = loop_->pollReturnTime();
+  }
+}
+
+void TcpConnection::reportStats()
+{
+  ConnectionStats delta;
+  delta.bytesReceived = stats_.bytesReceived - reportedStats_.bytesReceived;
+  delta.bytesSent = stats_.bytesSent - reportedStats_.bytesSent;
+  delta.reads = stats_.reads - reportedStats_.reads;
+  delta.writes = stats_.writes - reportedStats_.writes;
+  delta.messages = stats_.messages - reportedStats_.messages;
+  delta.messageMicros = stats_.messageMicros - reportedStats_.messageMicros;
+  loopGauge_->add(delta);
+  if (connectionGauge_)
+  {
+    connectionGauge_->add(delta);
+  }
+  reportedStats_ = stats_;
+}
+
 void TcpConnection::shutdown()
 {
   // FIXME: use compare and swap
@@ -210,18 +565,135 @@ void TcpConnection::shutdownInLoop()
   }
 }
 
+void TcpConnection::abortOutput()
+{
+  loop_->assertInLoopThread();
+  outputBuffer_.retrieveAll();
+  updatePendingOutputBytes();
+  if (channel_->isWriting())
+  {
+    channel_->disableWriting();
+  }
+  // send() takes no more till the close
+  setState(kDisconnecting);
+  loop_->queueInLoop(boost::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+  loop_->assertInLoopThread();
+  if (state_ == kConnected || state_ == kDisconnecting)
+  {
+    // as if we read 0 byte
+    handleClose();
+  }
+}
+
+void TcpConnection::startRead()
+{
+  loop_->runInLoop(boost::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop()
+{
+  loop_->assertInLoopThread();
+  reading_ = true;
+  // before connectEstablished(), or down already
+  if (state_ != kConnected && state_ != kDisconnecting)
+  {
+    return;
+  }
+  // a full relay pipe holds it back, relayWrite() enables it
+  if (!channel_->isReading() && !(relayOut_ && relayOut_->writableBytes() == 0))
+  {
+    channel_->enableReading();
+  }
+}
+
+void TcpConnection::stopRead()
+{
+  loop_->runInLoop(boost::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopReadInLoop()
+{
+  loop_->assertInLoopThread();
+  reading_ = false;
+  if (channel_->isReading())
+  {
+    channel_->disableReading();
+  }
+}
+
+bool TcpConnection::checkInputHighWaterMark()
+{
+  size_t len = inputBuffer_.readableBytes();
+  if (reading_ && inputHighWaterMark_ > 0 && len >= inputHighWaterMark_)
+  {
+    LOG_TRACE << "TcpConnection::checkInputHighWaterMark [" << name_
+              << "] - stop reading at " << len << " bytes";
+    stopReadInLoop();
+    if (inputHighWaterMarkCallback_)
+    {
+      loop_->queueInLoop(boost::bind(inputHighWaterMarkCallback_, shared_from_this(), len));
+    }
+  }
+  return !reading_;
+}
+
 void TcpConnection::setTcpNoDelay(bool on)
 {
   socket_->setTcpNoDelay(on);
 }
 
+void TcpConnection::setEdgeTriggered(bool on)
+{
+  assert(state_ == kConnecting);
+  if (on && !loop_->supportsEdgeTriggered())
+  {
+    LOG_WARN << "TcpConnection::setEdgeTriggered [" << name_
+             << "] - poller is level-triggered only";
+    return;
+  }
+  channel_->setEdgeTriggered(on);
+}
+
+void TcpConnection::setPooledBuffers(bool on)
+{
+  assert(state_ == kConnecting);
+  pooledBuffers_ = on;
+}
+
+void TcpConnection::setConnectionGauge(const ConnectionGaugePtr& gauge)
+{
+  assert(state_ == kConnecting);
+  assert(!connectionGauge_);
+  connectionGauge_ = gauge;
+}
+
+void TcpConnection::setBufferGauge(const BufferGaugePtr& gauge)
+{
+  assert(state_ == kConnecting);
+  assert(!bufferGauge_);
+  bufferGauge_ = gauge;
+}
+
 void TcpConnection::connectEstablished()
 {
   loop_->assertInLoopThread();
   assert(state_ == kConnecting);
   setState(kConnected);
   channel_->tie(shared_from_this());
-  channel_->enableReading();
+  if (reading_)
+  {
+    channel_->enableReading();
+  }
+  if (pooledBuffers_)
+  {
+    // give back what the ctor allocated, FIXME: don't allocate it
+    loop_->bufferPool()->release(&inputBuffer_);
+  }
+  updateInputBytes();
 
   connectionCallback_(shared_from_this());
 }
@@ -242,60 +714,268 @@ void TcpConnection::connectDestroyed()
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
   loop_->assertInLoopThread();
-  int savedErrno = 0;
-  ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
-  if (n > 0)
+  if (!reading_)
   {
-    messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    // stopped by user or by the mark, eg. POLLHUP with POLLIN,
+    // leave the data in the kernel and only take a bare EOF
+    char c;
+    if (::recv(channel_->fd(), &c, sizeof c, MSG_PEEK | MSG_DONTWAIT) == 0)
+    {
+      handleClose();
+    }
+    return;
   }
-  else if (n == 0)
+  if (relayOut_)
   {
-    handleClose();
+    relayRead();
+    reportStats();
+    return;
   }
-  else
+  // edge-triggered reads until EAGAIN, or a short read, which means the same
+  bool more = true;
+  while (more)
   {
-    errno = savedErrno;
-    LOG_SYSERR << "TcpConnection::handleRead";
-    handleError();
+    more = false;
+    int savedErrno = 0;
+    // nothing pending, read into the scratch buffer shared by the loop
+    Buffer* buf = pooledBuffers_ && inputBuffer_.readableBytes() == 0
+        ? loop_->bufferPool()->scratch() : &inputBuffer_;
+    const size_t writable = buf->writableBytes();
+    ssize_t n = buf->readFd(channel_->fd(), &savedErrno);
+    countRead(n);
+    if (n > 0)
+    {
+      // fitting in buf is a short read, but FIN may be queued
+      // behind the data, and its edge is gone
+      more = channel_->edgeTriggered()
+             && (implicit_cast<size_t>(n) > writable || (channel_->revents() & POLLRDHUP));
+      Timestamp start(Timestamp::now());
+      messageCallback_(shared_from_this(), buf, receiveTime);
+      ++stats_.messages;
+      stats_.messageMicros += Timestamp::now().microSecondsSinceEpoch()
+                              - start.microSecondsSinceEpoch();
+      if (buf != &inputBuffer_)
+      {
+        keepPartialMessage(buf);
+      }
+      else if (pooledBuffers_ && inputBuffer_.readableBytes() == 0)
+      {
+        loop_->bufferPool()->release(&inputBuffer_);
+      }
+      if (checkInputHighWaterMark())
+      {
+        // stopped by user or by the mark, leave the rest in the kernel
+        more = false;
+      }
+      else if (state_ == kDisconnected)
+      {
+        // closed in the callback, kDisconnecting reads on until EOF
+        more = false;
+      }
+    }
+    else if (n == 0)
+    {
+      handleClose();
+    }
+    else if (!(channel_->edgeTriggered() && savedErrno == EAGAIN))
+    {
+      errno = savedErrno;
+      LOG_SYSERR << "TcpConnection::handleRead";
+      handleError();
+    }
   }
+  updateInputBytes();
+  reportStats();
+}
+
+void TcpConnection::keepPartialMessage(Buffer* scratch)
+{
+  size_t len = scratch->readableBytes();
+  if (len > 0)
+  {
+    loop_->bufferPool()->acquire(&inputBuffer_);
+    inputBuffer_.append(scratch->peek(), len);
+    scratch->retrieveAll();
+  }
+}
+
+void TcpConnection::relayRead()
+{
+  bool more = true;
+  while (more)
+  {
+    more = false;
+    if (relayOut_->writableBytes() == 0)
+    {
+      // pipe is full, wait for the sink
+      channel_->disableReading();
+      break;
+    }
+    int savedErrno = 0;
+    ssize_t n = relayOut_->spliceFrom(channel_->fd(), &savedErrno);
+    countRead(n);
+    if (n > 0)
+    {
+      TcpConnectionPtr sink(relaySink_.lock());
+      if (sink)
+      {
+        sink->relayWrite();
+      }
+      else
+      {
+        relayOut_->discardAll();
+      }
+      more = channel_->edgeTriggered() || relayOut_->writableBytes() == 0;
+    }
+    else if (n == 0)
+    {
+      handleClose();
+    }
+    else if (savedErrno == EAGAIN)
+    {
+      // either nothing to read, or no room left in the pipe,
+      // splice(2) doesn't tell which
+      if (relayOut_->readableBytes() > 0)
+      {
+        channel_->disableReading();
+      }
+    }
+    else
+    {
+      errno = savedErrno;
+      LOG_SYSERR << "TcpConnection::relayRead";
+      handleError();
+    }
+  }
+}
+
+void TcpConnection::relayWrite()
+{
+  assert(relayIn_);
+  bool progress = false;
+  if (state_ == kDisconnected)
+  {
+    relayIn_->discardAll();
+    progress = true;
+  }
+  else if (outputBuffer_.readableBytes() > 0)
+  {
+    // handleWrite() comes back after them
+    return;
+  }
+
+  bool more = relayIn_->readableBytes() > 0;
+  while (more)
+  {
+    more = false;
+    int savedErrno = 0;
+    ssize_t n = relayIn_->spliceTo(channel_->fd(), &savedErrno);
+    countWrite(n);
+    if (n > 0)
+    {
+      progress = true;
+      more = channel_->edgeTriggered() && relayIn_->readableBytes() > 0;
+    }
+    else if (savedErrno != EAGAIN)
+    {
+      errno = savedErrno;
+      LOG_SYSERR << "TcpConnection::relayWrite";
+      relayIn_->discardAll();
+      progress = true;
+    }
+  }
+
+  if (relayIn_->readableBytes() > 0)
+  {
+    if (!channel_->isWriting())
+    {
+      channel_->enableWriting();
+    }
+  }
+  else if (channel_->isWriting())
+  {
+    channel_->disableWriting();
+    if (state_ == kDisconnecting)
+    {
+      shutdownInLoop();
+    }
+  }
+
+  if (progress)
+  {
+    // room in the pipe again
+    TcpConnectionPtr source(relaySource_.lock());
+    if (source && source->state_ != kDisconnected
+        && source->reading_ && !source->channel_->isReading())
+    {
+      source->channel_->enableReading();
+    }
+  }
+  reportStats();
 }
 
 void TcpConnection::handleWrite()
 {
   loop_->assertInLoopThread();
-  if (channel_->isWriting())
+  if (channel_->isWriting() && relayIn_ && outputBuffer_.readableBytes() == 0)
   {
-    ssize_t n = sockets::write(channel_->fd(),
-                               outputBuffer_.peek(),
-                               outputBuffer_.readableBytes());
-    if (n > 0)
+    relayWrite();
+  }
+  else if (channel_->isWriting())
+  {
+    // edge-triggered writes until empty or EAGAIN, no more event otherwise
+    bool more = true;
+    while (more)
     {
-      outputBuffer_.retrieve(n);
-      if (outputBuffer_.readableBytes() == 0)
+      more = false;
+      int savedErrno = 0;
+      ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+      countWrite(n);
+      if (n > 0)
       {
-        channel_->disableWriting();
-        if (writeCompleteCallback_)
+        updatePendingOutputBytes();
+        if (outputBuffer_.readableBytes() == 0)
         {
-          loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+          if (relayIn_)
+          {
+            // relayed bytes are queued behind
+            relayWrite();
+            break;
+          }
+          channel_->disableWriting();
+          if (writeCompleteCallback_)
+          {
+            loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+          }
+          if (state_ == kDisconnecting)
+          {
+            shutdownInLoop();
+          }
         }
-        if (state_ == kDisconnecting)
+        else
         {
-          shutdownInLoop();
+          LOG_TRACE << "I am going to write more data";
+          more = channel_->edgeTriggered();
         }
       }
-      else
+      else if (n == 0)
       {
-        LOG_TRACE << "I am going to write more data";
+        // a file region is gone, the byte stream can't go on
+        LOG_ERROR << "TcpConnection::handleWrite [" << name_
+                  << "] - file is shorter than what was sent";
+        abortOutput();
+      }
+      else if (!(channel_->edgeTriggered() && savedErrno == EAGAIN))
+      {
+        errno = savedErrno;
+        LOG_SYSERR << "TcpConnection::handleWrite";
+        // if (state_ == kDisconnecting)
+        // {
+        //   shutdownInLoop();
+        // }
       }
     }
-    else
-    {
-      LOG_SYSERR << "TcpConnection::handleWrite";
-      // if (state_ == kDisconnecting)
-      // {
-      //   shutdownInLoop();
-      // }
-    }
+    reportStats();
   }
   else
   {
@@ -312,6 +992,11 @@ void TcpConnection::handleClose()
   // we don't close fd, leave it to dtor, so we can find leaks easily.
   setState(kDisconnected);
   channel_->disableAll();
+  if (relayIn_)
+  {
+    // the source may be waiting for room in the pipe
+    relayWrite();
+  }
 
   TcpConnectionPtr guardThis(shared_from_this());
   connectionCallback_(guardThis);
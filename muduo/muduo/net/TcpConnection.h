@@ -11,18 +11,21 @@
 #ifndef MUDUO_NET_TCPCONNECTION_H
 #define MUDUO_NET_TCPCONNECTION_H
 
+#include <muduo/base/Atomic.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/StringPiece.h>
 #include <muduo/base/Types.h>
 #include <muduo/net/Callbacks.h>
 #include <muduo/net/Buffer.h>
+#include <muduo/net/BufferChain.h>
+#include <muduo/net/ConnectionStats.h>
 #include <muduo/net/InetAddress.h>
 
 #include <boost/any.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/noncopyable.hpp>
-#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 
 namespace muduo
 {
@@ -31,7 +34,21 @@ namespace net
 
 class Channel;
 class EventLoop;
+class SlabAllocator;
 class Socket;
+class SplicePipe;
+
+/// Immutable bytes shared by many connections, eg. a broadcast message.
+typedef string Payload;
+typedef boost::shared_ptr<const Payload> PayloadPtr;
+
+/// Bytes held by buffers of a group of connections, eg. of one TcpServer.
+struct BufferGauge : boost::noncopyable
+{
+  AtomicInt64 inputBytes;   // storage of input buffers
+  AtomicInt64 outputBytes;  // queued output
+};
+typedef boost::shared_ptr<BufferGauge> BufferGaugePtr;
 
 ///
 /// TCP connection, for both client and server usage.
@@ -57,13 +74,59 @@ class TcpConnection : boost::noncopyable,
   const InetAddress& peerAddress() { return peerAddr_; }
   bool connected() const { return state_ == kConnected; }
 
+  // statistics, in loop thread
+  const ConnectionStats& stats() const { return stats_; }
+  Timestamp creationTime() const { return creationTime_; }
+  /// Poll return time of the last read or write with some bytes.
+  Timestamp lastReceiveTime() const { return lastReceiveTime_; }
+  Timestamp lastSendTime() const { return lastSendTime_; }
+  /// Bytes queued for output, file regions of sendFile() included.
+  size_t outputBufferBytes() const { return outputBuffer_.readableBytes(); }
+
   // void send(string&& message); // C++11
   void send(const void* message, size_t len);
   void send(const StringPiece& message);
   // void send(Buffer&& message); // C++11
   void send(Buffer* message);  // this one will swap data
+  void send(const PayloadPtr& message);  // this one won't copy data
+  /// Sends a frame of slices, eg. header, linked body and trailer,
+  /// with one writev(2) if nothing is queued.
+  void send(BufferChain* message);  // this one will move slices
+  /// Sends [offset, offset+len) of file @c fd with sendfile(2), in order
+  /// with other sends.  @c fd is not owned, it must stay open until
+  /// WriteCompleteCallback, or until the connection is down.
+  /// Queued file bytes take no memory, so they don't count for the
+  /// high water mark.
+  void sendFile(int fd, off_t offset, size_t len);
+  /// Relays what is read from here to @c sink with splice(2) through a
+  /// pipe, the bytes never come to user space.  Bytes already in
+  /// inputBuffer() are sent first, MessageCallback is not called any
+  /// more.  Reading stops while the pipe is full, until @c sink drains it.
+  /// Call it both ways for a tunnel.  Don't send() to @c sink after this.
+  /// In loop thread, @c sink must be in the same loop.
+  void spliceTo(const TcpConnectionPtr& sink);
   void shutdown(); // NOT thread safe, no simultaneous calling
   void setTcpNoDelay(bool on);
+  /// Stops reading until startRead(), the socket buffers fill up and TCP
+  /// flow control slows the peer down.  A closed peer isn't noticed
+  /// while stopped.  Thread safe.
+  void startRead();
+  void stopRead();
+  bool isReading() const { return reading_; }  // NOT thread safe
+  /// Internal use only, must be called before connectEstablished().
+  /// Reads and writes until EAGAIN, without epoll_ctl for writing.
+  /// Ignored if the poller doesn't support it.
+  void setEdgeTriggered(bool on);
+  /// Internal use only, must be called before connectEstablished().
+  /// Reads land in a scratch buffer of the loop, input storage is taken
+  /// only for partial messages and goes back to the loop when drained.
+  /// The Buffer passed to MessageCallback may not be inputBuffer().
+  void setPooledBuffers(bool on);
+  /// Internal use only, must be called before connectEstablished().
+  void setBufferGauge(const BufferGaugePtr& gauge);
+  /// Internal use only, must be called before connectEstablished().
+  /// Traffic is added to @c gauge as well as to the loop's.
+  void setConnectionGauge(const ConnectionGaugePtr& gauge);
 
   void setContext(const boost::any& context)
   { context_ = context; }
@@ -86,6 +149,12 @@ class TcpConnection : boost::noncopyable,
   void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
   { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
 
+  /// Stops reading once inputBuffer() holds @c highWaterMark bytes after
+  /// MessageCallback, @c cb is called then and may be empty.  Consume
+  /// inputBuffer() and call startRead() to go on.  0 turns it off.
+  void setInputHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
+  { inputHighWaterMarkCallback_ = cb; inputHighWaterMark_ = highWaterMark; }
+
   Buffer* inputBuffer()
   { return &inputBuffer_; }
 
@@ -107,15 +176,56 @@ class TcpConnection : boost::noncopyable,
   //void sendInLoop(string&& message);
   void sendInLoop(const StringPiece& message);
   void sendInLoop(const void* message, size_t len);
+  void sendInLoop(Buffer* buf);
+  void sendInLoop(BufferChain* chain);
+  void sendChainInLoop(const boost::shared_ptr<BufferChain>& chain);
+  void sendFileInLoop(int fd, off_t offset, size_t len);
+  void sendSharedInLoop(const boost::shared_ptr<const void>& holder,
+                        const char* data,
+                        size_t len);
+  // returns bytes written, -1 if the connection is broken
+  ssize_t trySendDirectly(const void* data, size_t len);
+  void outputQueued(size_t oldLen);
+  // queued output bytes in memory, file regions excluded
+  size_t outputBytesInMemory() const
+  { return outputBuffer_.readableBytes() - outputBuffer_.fileBytes(); }
+  // reports changes of output buffer to loop_
+  void updatePendingOutputBytes();
+  void updateInputBytes();
+  // counts a syscall on the socket and bytes it moved
+  void countRead(ssize_t n);
+  void countWrite(ssize_t n);
+  // adds stats_ changed since last time to the gauges
+  void reportStats();
+  // keeps the rest of a message read into a shared scratch buffer
+  void keepPartialMessage(Buffer* scratch);
   void shutdownInLoop();
+  // the byte stream can't go on, closed after the callback we are in
+  void abortOutput();
+  void forceCloseInLoop();
+  void startReadInLoop();
+  void stopReadInLoop();
+  // stops reading if inputBuffer_ reaches inputHighWaterMark_
+  bool checkInputHighWaterMark();
+  // source side of spliceTo()
+  void relayRead();
+  // sink side of spliceTo(), after outputBuffer_ is empty
+  void relayWrite();
   void setState(StateE s) { state_ = s; }
 
   EventLoop* loop_;
+  // of loop_, for the dtor, which may run after the loop is gone
+  LoadGaugePtr loopLoad_;
+  ConnectionGaugePtr loopGauge_;
+  boost::shared_ptr<SlabAllocator> slabAllocator_;
   string name_;
   StateE state_;  // FIXME: use atomic variable
   // we don't expose those classes to client.
-  boost::scoped_ptr<Socket> socket_;
-  boost::scoped_ptr<Channel> channel_;
+  // both live in one block from slabAllocator_
+  struct SocketChannel;
+  SocketChannel* io_;
+  Socket* socket_;
+  Channel* channel_;
   InetAddress localAddr_;
   InetAddress peerAddr_;
   ConnectionCallback connectionCallback_;
@@ -124,11 +234,27 @@ class TcpConnection : boost::noncopyable,
   HighWaterMarkCallback highWaterMarkCallback_;
   CloseCallback closeCallback_;
   size_t highWaterMark_;
+  HighWaterMarkCallback inputHighWaterMarkCallback_;
+  size_t inputHighWaterMark_;
+  bool reading_;  // wanted by user, the channel may still wait for a relay pipe
   Buffer inputBuffer_;
-  Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer.
+  BufferChain outputBuffer_;
+  size_t reportedOutputBytes_;  // in loopLoad_->pendingOutputBytes
+  bool pooledBuffers_;
+  BufferGaugePtr bufferGauge_;
+  size_t reportedInputBytes_;  // in bufferGauge_->inputBytes
+  ConnectionGaugePtr connectionGauge_;
+  ConnectionStats stats_;
+  ConnectionStats reportedStats_;  // in loopGauge_ and connectionGauge_
+  Timestamp creationTime_;
+  Timestamp lastReceiveTime_;
+  Timestamp lastSendTime_;
+  // spliceTo(), pipes are shared by both ends
+  boost::shared_ptr<SplicePipe> relayOut_;
+  boost::weak_ptr<TcpConnection> relaySink_;
+  boost::shared_ptr<SplicePipe> relayIn_;
+  boost::weak_ptr<TcpConnection> relaySource_;
   boost::any context_;
-  // FIXME: creationTime_, lastReceiveTime_
-  //        bytesReceived_, bytesSent_
 };
 
 typedef boost::shared_ptr<TcpConnection> TcpConnectionPtr;
@@ -8,31 +8,60 @@
 
 #include <muduo/net/TcpServer.h>
 
+#include <muduo/base/CountDownLatch.h>
 #include <muduo/base/Logging.h>
 #include <muduo/net/Acceptor.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/EventLoopThreadPool.h>
+#include <muduo/net/SlabAllocator.h>
 #include <muduo/net/SocketsOps.h>
 
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 
 #include <stdio.h>  // snprintf
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+
+void connectEstablishedAll(const std::vector<TcpConnectionPtr>& conns)
+{
+  for (size_t i = 0; i < conns.size(); ++i)
+  {
+    conns[i]->connectEstablished();
+  }
+}
+
+void destroyAcceptor(Acceptor* acceptor, CountDownLatch* latch)
+{
+  delete acceptor;
+  latch->countDown();
+}
+
+}
+
 TcpServer::TcpServer(EventLoop* loop,
                      const InetAddress& listenAddr,
-                     const string& nameArg)
+                     const string& nameArg,
+                     Option option)
   : loop_(CHECK_NOTNULL(loop)),
+    listenAddr_(listenAddr),
     hostport_(listenAddr.toIpPort()),
     name_(nameArg),
-    acceptor_(new Acceptor(loop, listenAddr)),
+    // Unix-domain sockets can't share a path, one acceptor binds it
+    reusePort_(option == kReusePort && listenAddr.family() != AF_UNIX),
+    acceptor_(new Acceptor(loop, listenAddr, reusePort_)),
     threadPool_(new EventLoopThreadPool(loop)),
     connectionCallback_(defaultConnectionCallback),
     messageCallback_(defaultMessageCallback),
     started_(false),
-    nextConnId_(1)
+    maxAcceptsPerRead_(1),
+    edgeTriggered_(false),
+    pooledBuffers_(false),
+    bufferGauge_(new BufferGauge)
 {
   acceptor_->setNewConnectionCallback(
       boost::bind(&TcpServer::newConnection, this, _1, _2));
@@ -43,6 +72,18 @@ TcpServer::~TcpServer()
   loop_->assertInLoopThread();
   LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
 
+  if (!ioAcceptors_.empty())
+  {
+    CountDownLatch latch(static_cast<int>(ioAcceptors_.size()));
+    for (size_t i = 0; i < ioAcceptors_.size(); ++i)
+    {
+      ioAcceptors_[i]->getLoop()->runInLoop(
+          boost::bind(destroyAcceptor, ioAcceptors_[i], &latch));
+    }
+    latch.wait();
+    ioAcceptors_.clear();
+  }
+
   for (ConnectionMap::iterator it(connections_.begin());
       it != connections_.end(); ++it)
   {
@@ -60,48 +101,184 @@ void TcpServer::setThreadNum(int numThreads)
   threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setThreadSelectionPolicy(EventLoopThreadPool::SelectionPolicy policy)
+{
+  threadPool_->setSelectionPolicy(policy);
+}
+
+void TcpServer::setMaxAcceptsPerRead(int maxAccepts)
+{
+  assert(0 < maxAccepts);
+  assert(!started_);
+  acceptor_->setMaxAcceptsPerRead(maxAccepts);
+  maxAcceptsPerRead_ = maxAccepts;
+  if (maxAcceptsPerRead_ > 1)
+  {
+    acceptor_->setAcceptBatchCallback(
+        boost::bind(&TcpServer::dispatchPendingConnections, this));
+  }
+  else
+  {
+    acceptor_->setAcceptBatchCallback(Acceptor::AcceptBatchCallback());
+  }
+}
+
 void TcpServer::start()
 {
   if (!started_)
   {
     started_ = true;
     threadPool_->start(threadInitCallback_);
+    std::vector<EventLoop*> loops(threadPool_->getAllLoops());
+    for (size_t i = 0; i < loops.size(); ++i)
+    {
+      connectionGauges_[loops[i]].reset(new ConnectionGauge);
+    }
+    if (reusePort_)
+    {
+      createIoAcceptors();
+    }
   }
 
-  if (!acceptor_->listenning())
+  if (!ioAcceptors_.empty())
+  {
+    for (size_t i = 0; i < ioAcceptors_.size(); ++i)
+    {
+      Acceptor* acceptor = ioAcceptors_[i];
+      if (!acceptor->listenning())
+      {
+        acceptor->getLoop()->runInLoop(
+            boost::bind(&Acceptor::listen, acceptor));
+      }
+    }
+  }
+  else if (!acceptor_->listenning())
   {
     loop_->runInLoop(
         boost::bind(&Acceptor::listen, get_pointer(acceptor_)));
   }
 }
 
+void TcpServer::createIoAcceptors()
+{
+  loop_->assertInLoopThread();
+  std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+  if (loops.size() == 1 && loops[0] == loop_)
+  {
+    // no thread, acceptor_ is in the only I/O loop
+    return;
+  }
+
+  // acceptor_ stays bound but never listens
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    EventLoop* ioLoop = loops[i];
+    Acceptor* acceptor = new Acceptor(ioLoop, listenAddr_, true);
+    acceptor->setMaxAcceptsPerRead(maxAcceptsPerRead_);
+    acceptor->setNewConnectionCallback(
+        boost::bind(&TcpServer::newConnectionInIoLoop, this, ioLoop, _1, _2));
+    ioAcceptors_.push_back(acceptor);
+  }
+}
+
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
   loop_->assertInLoopThread();
-  EventLoop* ioLoop = threadPool_->getNextLoop();
+  EventLoop* ioLoop = threadPool_->getLoopForConnection(peerAddr);
+  TcpConnectionPtr conn(createConnection(ioLoop, sockfd, peerAddr));
+  connections_[conn->name()] = conn;
+  if (maxAcceptsPerRead_ > 1)
+  {
+    pendingConnections_[ioLoop].push_back(conn);
+  }
+  else
+  {
+    ioLoop->runInLoop(boost::bind(&TcpConnection::connectEstablished, conn));
+  }
+}
+
+void TcpServer::newConnectionInIoLoop(EventLoop* ioLoop,
+                                      int sockfd,
+                                      const InetAddress& peerAddr)
+{
+  ioLoop->assertInLoopThread();
+  TcpConnectionPtr conn(createConnection(ioLoop, sockfd, peerAddr));
+  conn->connectEstablished();
+  // removeConnection() is queued after it, in the same order
+  loop_->queueInLoop(
+      boost::bind(&TcpServer::addConnectionInLoop, this, conn)); // FIXME: unsafe
+}
+
+void TcpServer::addConnectionInLoop(const TcpConnectionPtr& conn)
+{
+  loop_->assertInLoopThread();
+  connections_[conn->name()] = conn;
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop* ioLoop,
+                                             int sockfd,
+                                             const InetAddress& peerAddr)
+{
+  // hostport_ may be a long IPv6 address or Unix-domain path
   char buf[32];
-  snprintf(buf, sizeof buf, ":%s#%d", hostport_.c_str(), nextConnId_);
-  ++nextConnId_;
-  string connName = name_ + buf;
+  snprintf(buf, sizeof buf, "#%d", nextConnId_.incrementAndGet());
+  string connName = name_ + ":" + hostport_ + buf;
 
   LOG_INFO << "TcpServer::newConnection [" << name_
            << "] - new connection [" << connName
            << "] from " << peerAddr.toIpPort();
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
-  // FIXME use make_shared if necessary
-  TcpConnectionPtr conn(new TcpConnection(ioLoop,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));
-  connections_[connName] = conn;
+  // TcpConnection and its reference count share a block of the loop's slab
+  TcpConnectionPtr conn(boost::allocate_shared<TcpConnection>(
+        LoopAllocator<TcpConnection>(ioLoop->slabAllocator()),
+        ioLoop, connName, sockfd, localAddr, peerAddr));
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
   conn->setCloseCallback(
       boost::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
-  ioLoop->runInLoop(boost::bind(&TcpConnection::connectEstablished, conn));
+  if (edgeTriggered_)
+  {
+    conn->setEdgeTriggered(true);
+  }
+  conn->setPooledBuffers(pooledBuffers_);
+  conn->setBufferGauge(bufferGauge_);
+  conn->setConnectionGauge(connectionGauges_.find(ioLoop)->second);
+  return conn;
+}
+
+ConnectionStats TcpServer::connectionStats() const
+{
+  ConnectionStats sum;
+  bzero(&sum, sizeof sum);
+  for (ConnectionGaugeMap::const_iterator it = connectionGauges_.begin();
+      it != connectionGauges_.end(); ++it)
+  {
+    ConnectionStats stats = it->second->get();
+    sum.bytesReceived += stats.bytesReceived;
+    sum.bytesSent += stats.bytesSent;
+    sum.reads += stats.reads;
+    sum.writes += stats.writes;
+    sum.messages += stats.messages;
+    sum.messageMicros += stats.messageMicros;
+  }
+  return sum;
+}
+
+void TcpServer::dispatchPendingConnections()
+{
+  loop_->assertInLoopThread();
+  for (PendingConnectionMap::iterator it = pendingConnections_.begin();
+      it != pendingConnections_.end(); ++it)
+  {
+    ConnectionList& conns = it->second;
+    if (!conns.empty())
+    {
+      it->first->runInLoop(boost::bind(connectEstablishedAll, conns));
+      conns.clear();
+    }
+  }
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
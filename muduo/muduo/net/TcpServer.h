@@ -11,10 +11,13 @@
 #ifndef MUDUO_NET_TCPSERVER_H
 #define MUDUO_NET_TCPSERVER_H
 
+#include <muduo/base/Atomic.h>
 #include <muduo/base/Types.h>
+#include <muduo/net/EventLoopThreadPool.h>
 #include <muduo/net/TcpConnection.h>
 
 #include <map>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 
@@ -25,7 +28,6 @@ namespace net
 
 class Acceptor;
 class EventLoop;
-class EventLoopThreadPool;
 
 ///
 /// TCP server, supports single-threaded and thread-pool models.
@@ -35,11 +37,21 @@ class TcpServer : boost::noncopyable
 {
  public:
   typedef boost::function<void(EventLoop*)> ThreadInitCallback;
+  enum Option
+  {
+    kNoReusePort,
+    kReusePort
+  };
 
   //TcpServer(EventLoop* loop, const InetAddress& listenAddr);
+  /// With @c kReusePort, every I/O loop listens on its own SO_REUSEPORT
+  /// socket and accepts its own connections, the kernel balances them.
+  /// @c loop still keeps track of all connections.  Ignored for a
+  /// Unix-domain @c listenAddr, whose path only one socket can bind.
   TcpServer(EventLoop* loop,
             const InetAddress& listenAddr,
-            const string& nameArg);
+            const string& nameArg,
+            Option option = kNoReusePort);
   ~TcpServer();  // force out-line dtor, for scoped_ptr members.
 
   const string& hostport() const { return hostport_; }
@@ -47,7 +59,7 @@ class TcpServer : boost::noncopyable
 
   /// Set the number of threads for handling input.
   ///
-  /// Always accepts new connection in loop's thread.
+  /// Accepts new connection in loop's thread, unless @c kReusePort.
   /// Must be called before @c start
   /// @param numThreads
   /// - 0 means all I/O in loop's thread, no thread will created.
@@ -59,6 +71,44 @@ class TcpServer : boost::noncopyable
   void setThreadInitCallback(const ThreadInitCallback& cb)
   { threadInitCallback_ = cb; }
 
+  /// Set how a new connection picks its I/O loop, default is round-robin.
+  ///
+  /// Not used with @c kReusePort, the kernel picks the loop.
+  void setThreadSelectionPolicy(EventLoopThreadPool::SelectionPolicy policy);
+
+  /// Set the max number of connections accepted per readiness event.
+  ///
+  /// Must be called before @c start
+  /// @param maxAccepts
+  /// - 1 means one accept(2) per poll, this is the default value.
+  /// - N means accepting until EAGAIN or N connections, those accepted
+  ///   together are handed to each I/O loop in one functor.
+  void setMaxAcceptsPerRead(int maxAccepts);
+
+  /// Registers connections edge-triggered, if the poller supports it.
+  ///
+  /// Saves an epoll_ctl() each time the output buffer fills or drains,
+  /// every readiness event reads or writes until EAGAIN.
+  /// Must be called before @c start
+  void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+  /// Connections read into a scratch buffer of their loop, and keep
+  /// input storage only while holding a partial message, so idle ones
+  /// pin no memory.  MessageCallback may get a Buffer other than
+  /// TcpConnection::inputBuffer().
+  /// Must be called before @c start
+  void setPooledBuffers(bool on) { pooledBuffers_ = on; }
+
+  /// Bytes of input buffer storage held by connections.
+  /// Thread safe.
+  int64_t inputBufferBytes() const { return bufferGauge_->inputBytes.get(); }
+  /// Bytes queued for output by connections.
+  /// Thread safe.
+  int64_t outputBufferBytes() const { return bufferGauge_->outputBytes.get(); }
+  /// Traffic of all connections so far, summed over I/O loops.
+  /// Thread safe, after @c start.
+  ConnectionStats connectionStats() const;
+
   /// Starts the server if it's not listenning.
   ///
   /// It's harmless to call it multiple times.
@@ -83,26 +133,49 @@ class TcpServer : boost::noncopyable
  private:
   /// Not thread safe, but in loop
   void newConnection(int sockfd, const InetAddress& peerAddr);
+  /// Not thread safe, but in ioLoop, for kReusePort
+  void newConnectionInIoLoop(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
+  /// Not thread safe, but in loop
+  void addConnectionInLoop(const TcpConnectionPtr& conn);
+  /// Not thread safe, but in loop
+  void dispatchPendingConnections();
   /// Thread safe.
   void removeConnection(const TcpConnectionPtr& conn);
   /// Not thread safe, but in loop
   void removeConnectionInLoop(const TcpConnectionPtr& conn);
+  TcpConnectionPtr createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
+  void createIoAcceptors();
 
   typedef std::map<string, TcpConnectionPtr> ConnectionMap;
+  typedef std::vector<TcpConnectionPtr> ConnectionList;
+  typedef std::map<EventLoop*, ConnectionList> PendingConnectionMap;
+  typedef std::map<EventLoop*, ConnectionGaugePtr> ConnectionGaugeMap;
 
   EventLoop* loop_;  // the acceptor loop
+  const InetAddress listenAddr_;
   const string hostport_;
   const string name_;
+  const bool reusePort_;
   boost::scoped_ptr<Acceptor> acceptor_; // avoid revealing Acceptor
+  // one for each I/O loop if kReusePort, deleted in its loop
+  std::vector<Acceptor*> ioAcceptors_;
   boost::scoped_ptr<EventLoopThreadPool> threadPool_;
   ConnectionCallback connectionCallback_;
   MessageCallback messageCallback_;
   WriteCompleteCallback writeCompleteCallback_;
   ThreadInitCallback threadInitCallback_;
   bool started_;
+  int maxAcceptsPerRead_;
+  bool edgeTriggered_;
+  bool pooledBuffers_;
+  BufferGaugePtr bufferGauge_;
+  // one for each I/O loop, filled in start()
+  ConnectionGaugeMap connectionGauges_;
+  AtomicInt32 nextConnId_;
   // always in loop thread
-  int nextConnId_;
   ConnectionMap connections_;
+  // accepted in current readiness event, if batching
+  PendingConnectionMap pendingConnections_;
 };
 
 }
@@ -8,10 +8,13 @@
 
 #include <muduo/net/Timer.h>
 
+#include <assert.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
 AtomicInt64 Timer::s_numCreated_;
+AtomicInt64 Timer::s_sequence_;
 
 void Timer::restart(Timestamp now)
 {
@@ -24,3 +27,20 @@ void Timer::restart(Timestamp now)
     expiration_ = Timestamp::invalid();
   }
 }
+
+void Timer::reset(const TimerCallback& cb, Timestamp when, double interval)
+{
+  assert(sequence_ == 0 && !queued_);
+  callback_ = cb;
+  expiration_ = when;
+  interval_ = interval;
+  repeat_ = interval > 0.0;
+  sequence_ = s_sequence_.incrementAndGet();
+}
+
+void Timer::retire()
+{
+  assert(!queued_);
+  callback_ = TimerCallback();
+  sequence_ = 0;
+}
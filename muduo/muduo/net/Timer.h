@@ -24,6 +24,8 @@ namespace net
 ///
 /// Internal class for timer event.
 ///
+/// Timers are recycled by TimerQueue, a retired timer gets a new sequence
+/// when reused, so stale TimerIds never match it.
 class Timer : boost::noncopyable
 {
  public:
@@ -32,8 +34,14 @@ class Timer : boost::noncopyable
       expiration_(when),
       interval_(interval),
       repeat_(interval > 0.0),
-      sequence_(s_numCreated_.incrementAndGet())
-  { }
+      sequence_(s_sequence_.incrementAndGet()),
+      queued_(false),
+      prev_(NULL),
+      next_(NULL),
+      slot_(-1)
+  {
+    s_numCreated_.increment();
+  }
 
   void run() const
   {
@@ -46,16 +54,34 @@ class Timer : boost::noncopyable
 
   void restart(Timestamp now);
 
+  /// Reuses a retired timer.
+  void reset(const TimerCallback& cb, Timestamp when, double interval);
+  /// Releases the callback, sequence becomes 0.
+  void retire();
+
+  // whether it is in a TimerList, maintained by TimerQueue
+  bool queued() const { return queued_; }
+  void setQueued(bool on) { queued_ = on; }
+
   static int64_t numCreated() { return s_numCreated_.get(); }
 
  private:
-  const TimerCallback callback_;
+  friend class WheelTimerList;
+
+  TimerCallback callback_;
   Timestamp expiration_;
-  const double interval_;
-  const bool repeat_;
-  const int64_t sequence_;
+  double interval_;
+  bool repeat_;
+  int64_t sequence_;
+  bool queued_;
+
+  // intrusive list node of WheelTimerList
+  Timer* prev_;
+  Timer* next_;
+  int slot_;
 
-  static AtomicInt64 s_numCreated_;
+  static AtomicInt64 s_numCreated_;  // new timers, not reuses
+  static AtomicInt64 s_sequence_;
 };
 }
 }
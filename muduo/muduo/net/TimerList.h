@@ -0,0 +1,55 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMERLIST_H
+#define MUDUO_NET_TIMERLIST_H
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include <muduo/base/Timestamp.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class Timer;
+
+///
+/// Base class for storing pending timers of TimerQueue.
+///
+/// Owns the timers in it, deletes them in dtor.
+/// Must be used in the loop thread.
+class TimerList : boost::noncopyable
+{
+ public:
+  TimerList();
+  virtual ~TimerList();
+
+  /// @return true if nextExpiration() becomes earlier.
+  virtual bool insert(Timer* timer) = 0;
+
+  virtual void erase(Timer* timer) = 0;
+
+  /// Moves out timers expired at @c now.
+  virtual void getExpired(Timestamp now, std::vector<Timer*>* expired) = 0;
+
+  /// When to call getExpired() next time, invalid if empty.
+  virtual Timestamp nextExpiration() const = 0;
+
+  virtual size_t size() const = 0;
+
+  static TimerList* newDefaultTimerList();
+};
+
+}
+}
+#endif  // MUDUO_NET_TIMERLIST_H
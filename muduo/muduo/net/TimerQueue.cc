@@ -6,13 +6,13 @@
 
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
-#define __STDC_LIMIT_MACROS
 #include <muduo/net/TimerQueue.h>
 
 #include <muduo/base/Logging.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/Timer.h>
 #include <muduo/net/TimerId.h>
+#include <muduo/net/TimerList.h>
 
 #include <boost/bind.hpp>
 
@@ -90,7 +90,8 @@ TimerQueue::TimerQueue(EventLoop* loop)
   : loop_(loop),
     timerfd_(createTimerfd()),
     timerfdChannel_(loop, timerfd_),
-    timers_(),
+    timers_(TimerList::newDefaultTimerList()),
+    slackMicros_(0),
     callingExpiredTimers_(false)
 {
   timerfdChannel_.setReadCallback(
@@ -103,10 +104,11 @@ TimerQueue::~TimerQueue()
 {
   ::close(timerfd_);
   // do not remove channel, since we're in EventLoop::dtor();
-  for (TimerList::iterator it = timers_.begin();
-      it != timers_.end(); ++it)
+  // timers_ deletes pending timers
+  for (std::vector<Timer*>::iterator it = freeTimers_.begin();
+      it != freeTimers_.end(); ++it)
   {
-    delete it->second;
+    delete *it;
   }
 }
 
@@ -114,10 +116,25 @@ TimerId TimerQueue::addTimer(const TimerCallback& cb,
                              Timestamp when,
                              double interval)
 {
-  Timer* timer = new Timer(cb, when, interval);
-  loop_->runInLoop(
-      boost::bind(&TimerQueue::addTimerInLoop, this, timer));
-  return TimerId(timer, timer->sequence());
+  Timer* timer = NULL;
+  int64_t sequence = 0;
+  if (loop_->isInLoopThread() && !freeTimers_.empty())
+  {
+    timer = freeTimers_.back();
+    freeTimers_.pop_back();
+    timer->reset(cb, when, interval);
+    sequence = timer->sequence();
+    addTimerInLoop(timer);
+  }
+  else
+  {
+    timer = new Timer(cb, when, interval);
+    // the loop thread owns it from now on, may retire and reuse it
+    sequence = timer->sequence();
+    loop_->runInLoop(
+        boost::bind(&TimerQueue::addTimerInLoop, this, timer));
+  }
+  return TimerId(timer, sequence);
 }
 
 void TimerQueue::cancel(TimerId timerId)
@@ -126,6 +143,13 @@ void TimerQueue::cancel(TimerId timerId)
       boost::bind(&TimerQueue::cancelInLoop, this, timerId));
 }
 
+void TimerQueue::setSlack(double seconds)
+{
+  loop_->assertInLoopThread();
+  assert(seconds >= 0.0);
+  slackMicros_ = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+}
+
 void TimerQueue::addTimerInLoop(Timer* timer)
 {
   loop_->assertInLoopThread();
@@ -133,28 +157,30 @@ void TimerQueue::addTimerInLoop(Timer* timer)
 
   if (earliestChanged)
   {
-    resetTimerfd(timerfd_, timer->expiration());
+    rearm(timers_->nextExpiration());
   }
 }
 
 void TimerQueue::cancelInLoop(TimerId timerId)
 {
   loop_->assertInLoopThread();
-  assert(timers_.size() == activeTimers_.size());
-  ActiveTimer timer(timerId.timer_, timerId.sequence_);
-  ActiveTimerSet::iterator it = activeTimers_.find(timer);
-  if (it != activeTimers_.end())
+  Timer* timer = timerId.timer_;
+  // timer is not deleted, but could be retired or reused
+  if (timer == NULL || timer->sequence() != timerId.sequence_)
+  {
+    return;
+  }
+
+  if (timer->queued())
   {
-    size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
-    assert(n == 1); (void)n;
-    delete it->first; // FIXME: no delete please
-    activeTimers_.erase(it);
+    timers_->erase(timer);
+    timer->setQueued(false);
+    recycle(timer);
   }
   else if (callingExpiredTimers_)
   {
-    cancelingTimers_.insert(timer);
+    cancelingTimers_.insert(ActiveTimer(timer, timerId.sequence_));
   }
-  assert(timers_.size() == activeTimers_.size());
 }
 
 void TimerQueue::handleRead()
@@ -162,99 +188,84 @@ void TimerQueue::handleRead()
   loop_->assertInLoopThread();
   Timestamp now(Timestamp::now());
   readTimerfd(timerfd_, now);
+  // one-shot, it's disarmed now
+  armed_ = Timestamp::invalid();
 
-  std::vector<Entry> expired = getExpired(now);
+  expired_.clear();
+  timers_->getExpired(now, &expired_);
+  for (std::vector<Timer*>::iterator it = expired_.begin();
+      it != expired_.end(); ++it)
+  {
+    (*it)->setQueued(false);
+  }
 
   callingExpiredTimers_ = true;
   cancelingTimers_.clear();
   // safe to callback outside critical section
-  for (std::vector<Entry>::iterator it = expired.begin();
-      it != expired.end(); ++it)
+  for (std::vector<Timer*>::iterator it = expired_.begin();
+      it != expired_.end(); ++it)
   {
-    it->second->run();
+    (*it)->run();
   }
   callingExpiredTimers_ = false;
 
-  reset(expired, now);
+  reset(expired_, now);
 }
 
-std::vector<TimerQueue::Entry> TimerQueue::getExpired(Timestamp now)
+void TimerQueue::reset(const std::vector<Timer*>& expired, Timestamp now)
 {
-  assert(timers_.size() == activeTimers_.size());
-  std::vector<Entry> expired;
-  Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
-  TimerList::iterator end = timers_.lower_bound(sentry);
-  assert(end == timers_.end() || now < end->first);
-  std::copy(timers_.begin(), end, back_inserter(expired));
-  timers_.erase(timers_.begin(), end);
-
-  for (std::vector<Entry>::iterator it = expired.begin();
+  for (std::vector<Timer*>::const_iterator it = expired.begin();
       it != expired.end(); ++it)
   {
-    ActiveTimer timer(it->second, it->second->sequence());
-    size_t n = activeTimers_.erase(timer);
-    assert(n == 1); (void)n;
-  }
-
-  assert(timers_.size() == activeTimers_.size());
-  return expired;
-}
-
-void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
-{
-  Timestamp nextExpire;
-
-  for (std::vector<Entry>::const_iterator it = expired.begin();
-      it != expired.end(); ++it)
-  {
-    ActiveTimer timer(it->second, it->second->sequence());
-    if (it->second->repeat()
-        && cancelingTimers_.find(timer) == cancelingTimers_.end())
+    Timer* timer = *it;
+    ActiveTimer active(timer, timer->sequence());
+    if (timer->repeat()
+        && cancelingTimers_.find(active) == cancelingTimers_.end())
     {
-      it->second->restart(now);
-      insert(it->second);
+      timer->restart(now);
+      insert(timer);
     }
     else
     {
-      // FIXME move to a free list
-      delete it->second; // FIXME: no delete please
+      recycle(timer);
     }
   }
 
-  if (!timers_.empty())
+  Timestamp nextExpire = timers_->nextExpiration();
+  if (nextExpire.valid())
   {
-    nextExpire = timers_.begin()->second->expiration();
+    rearm(nextExpire);
   }
+}
 
-  if (nextExpire.valid())
+void TimerQueue::rearm(Timestamp earliest)
+{
+  // the armed wakeup fires it as well, if it's late by the slack at most
+  if (armed_.valid())
   {
-    resetTimerfd(timerfd_, nextExpire);
+    int64_t late = armed_.microSecondsSinceEpoch() - earliest.microSecondsSinceEpoch();
+    if (0 <= late && late <= slackMicros_)
+    {
+      return;
+    }
   }
+  // late by the slack, so timers due meanwhile expire together
+  armed_ = Timestamp(earliest.microSecondsSinceEpoch() + slackMicros_);
+  resetTimerfd(timerfd_, armed_);
+  ++loop_->syscallStats().timerUpdates;
 }
 
 bool TimerQueue::insert(Timer* timer)
 {
   loop_->assertInLoopThread();
-  assert(timers_.size() == activeTimers_.size());
-  bool earliestChanged = false;
-  Timestamp when = timer->expiration();
-  TimerList::iterator it = timers_.begin();
-  if (it == timers_.end() || when < it->first)
-  {
-    earliestChanged = true;
-  }
-  {
-    std::pair<TimerList::iterator, bool> result
-      = timers_.insert(Entry(when, timer));
-    assert(result.second); (void)result;
-  }
-  {
-    std::pair<ActiveTimerSet::iterator, bool> result
-      = activeTimers_.insert(ActiveTimer(timer, timer->sequence()));
-    assert(result.second); (void)result;
-  }
-
-  assert(timers_.size() == activeTimers_.size());
+  assert(!timer->queued());
+  bool earliestChanged = timers_->insert(timer);
+  timer->setQueued(true);
   return earliestChanged;
 }
 
+void TimerQueue::recycle(Timer* timer)
+{
+  timer->retire();
+  freeTimers_.push_back(timer);
+}
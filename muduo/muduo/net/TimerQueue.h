@@ -15,6 +15,7 @@
 #include <vector>
 
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Timestamp.h>
@@ -29,16 +30,24 @@ namespace net
 class EventLoop;
 class Timer;
 class TimerId;
+class TimerList;
 
 ///
 /// A best efforts timer queue.
 /// No guarantee that the callback will be on time.
 ///
+/// Set MUDUO_USE_TIMER_WHEEL to store timers in a hierarchical timing wheel,
+/// instead of a std::set.
+///
+/// With a slack, timers due within it share one timerfd wakeup, and
+/// a wakeup armed already is kept if it's within the slack of the
+/// earliest timer.  Timers may fire that much later, never earlier.
+///
 class TimerQueue : boost::noncopyable
 {
  public:
   TimerQueue(EventLoop* loop);
-  ~TimerQueue();
+  ~TimerQueue();  // force out-line dtor, for scoped_ptr members.
 
   ///
   /// Schedules the callback to be run at given time,
@@ -51,11 +60,15 @@ class TimerQueue : boost::noncopyable
 
   void cancel(TimerId timerId);
 
+  /// For EventLoop to tell timer callbacks from others.
+  int fd() const { return timerfd_; }
+
+  /// 0 by default, each timer gets a wakeup of its own.
+  /// In loop thread.
+  void setSlack(double seconds);
+
  private:
 
-  // FIXME: use unique_ptr<Timer> instead of raw pointers.
-  typedef std::pair<Timestamp, Timer*> Entry;
-  typedef std::set<Entry> TimerList;
   typedef std::pair<Timer*, int64_t> ActiveTimer;
   typedef std::set<ActiveTimer> ActiveTimerSet;
 
@@ -63,20 +76,25 @@ class TimerQueue : boost::noncopyable
   void cancelInLoop(TimerId timerId);
   // called when timerfd alarms
   void handleRead();
-  // move out all expired timers
-  std::vector<Entry> getExpired(Timestamp now);
-  void reset(const std::vector<Entry>& expired, Timestamp now);
+  void reset(const std::vector<Timer*>& expired, Timestamp now);
+  // arms timerfd for the earliest timer, unless the armed time will do
+  void rearm(Timestamp earliest);
 
   bool insert(Timer* timer);
+  void recycle(Timer* timer);
 
   EventLoop* loop_;
   const int timerfd_;
   Channel timerfdChannel_;
-  // Timer list sorted by expiration
-  TimerList timers_;
-
-  // for cancel()
-  ActiveTimerSet activeTimers_;
+  // pending timers, sorted by expiration
+  boost::scoped_ptr<TimerList> timers_;
+  int64_t slackMicros_;
+  Timestamp armed_;  // when timerfd goes off, invalid if it's not armed
+
+  // retired timers, never deleted before TimerQueue,
+  // so that TimerId of an expired timer can be checked safely.
+  std::vector<Timer*> freeTimers_;
+  std::vector<Timer*> expired_;
   bool callingExpiredTimers_; /* atomic */
   ActiveTimerSet cancelingTimers_;
 };
@@ -0,0 +1,86 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/UdpClient.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/DatagramSocket.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+UdpClient::UdpClient(EventLoop* loop,
+                     const InetAddress& serverAddr,
+                     const string& nameArg)
+  : loop_(CHECK_NOTNULL(loop)),
+    serverAddr_(serverAddr),
+    name_(nameArg),
+    batchSize_(DatagramSocket::kDefaultBatchSize),
+    maxDatagramSize_(DatagramSocket::kDefaultMaxDatagramSize)
+{
+}
+
+UdpClient::~UdpClient()
+{
+  LOG_TRACE << "UdpClient::~UdpClient [" << name_ << "] destructing";
+}
+
+void UdpClient::connect()
+{
+  loop_->assertInLoopThread();
+  assert(!socket_);
+  int sockfd = sockets::createNonblockingUdpOrDie(serverAddr_.family());
+  socket_.reset(new DatagramSocket(loop_, sockfd, batchSize_, maxDatagramSize_));
+  // never blocks for UDP
+  if (sockets::connect(sockfd, serverAddr_.getSockAddr(), serverAddr_.getSockLen()) < 0)
+  {
+    LOG_SYSERR << "UdpClient::connect [" << name_ << "] to "
+               << serverAddr_.toIpPort();
+  }
+  socket_->setMessageCallback(messageCallback_);
+  socket_->start();
+}
+
+void UdpClient::send(const void* data, size_t len)
+{
+  send(StringPiece(static_cast<const char*>(data), static_cast<int>(len)));
+}
+
+void UdpClient::send(const StringPiece& message)
+{
+  if (loop_->isInLoopThread())
+  {
+    assert(socket_);
+    socket_->send(NULL, 0, message.data(), message.size());
+  }
+  else
+  {
+    loop_->runInLoop(
+        boost::bind(&UdpClient::sendInLoop,
+                    this,     // FIXME
+                    message.as_string()));
+  }
+}
+
+void UdpClient::sendInLoop(const string& message)
+{
+  loop_->assertInLoopThread();
+  assert(socket_);
+  socket_->send(NULL, 0, message.data(), message.size());
+}
+
+const DatagramStats& UdpClient::stats() const
+{
+  loop_->assertInLoopThread();
+  assert(socket_);
+  return socket_->stats();
+}
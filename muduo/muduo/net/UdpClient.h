@@ -0,0 +1,81 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPCLIENT_H
+#define MUDUO_NET_UDPCLIENT_H
+
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
+#include <muduo/net/Callbacks.h>
+#include <muduo/net/DatagramStats.h>
+#include <muduo/net/InetAddress.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class DatagramSocket;
+class EventLoop;
+
+///
+/// UDP client on a connected socket, in batches like UdpServer.
+///
+/// Datagrams from others than the server are filtered by the kernel.
+class UdpClient : boost::noncopyable
+{
+ public:
+  UdpClient(EventLoop* loop,
+            const InetAddress& serverAddr,
+            const string& nameArg);
+  ~UdpClient();  // force out-line dtor, for scoped_ptr members.
+
+  const string& name() const { return name_; }
+  EventLoop* getLoop() const { return loop_; }
+
+  /// Must be called before connect().
+  void setBatchSize(int batchSize) { batchSize_ = batchSize; }
+  /// Must be called before connect().
+  void setMaxDatagramSize(size_t size) { maxDatagramSize_ = size; }
+
+  /// Set message callback.
+  /// Not thread safe.
+  void setMessageCallback(const DatagramCallback& cb)
+  { messageCallback_ = cb; }
+
+  /// Fixes the peer of the socket and starts receiving, in loop thread.
+  void connect();
+
+  /// Thread safe, after connect().
+  void send(const void* data, size_t len);
+  void send(const StringPiece& message);
+
+  /// In loop thread.
+  const DatagramStats& stats() const;
+
+ private:
+  void sendInLoop(const string& message);
+
+  EventLoop* loop_;
+  const InetAddress serverAddr_;
+  const string name_;
+  int batchSize_;
+  size_t maxDatagramSize_;
+  DatagramCallback messageCallback_;
+  boost::scoped_ptr<DatagramSocket> socket_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_UDPCLIENT_H
@@ -0,0 +1,86 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/UdpServer.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/DatagramSocket.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+UdpServer::UdpServer(EventLoop* loop,
+                     const InetAddress& listenAddr,
+                     const string& nameArg)
+  : loop_(CHECK_NOTNULL(loop)),
+    name_(nameArg),
+    sockfd_(sockets::createNonblockingUdpOrDie(listenAddr.family())),
+    batchSize_(DatagramSocket::kDefaultBatchSize),
+    maxDatagramSize_(DatagramSocket::kDefaultMaxDatagramSize)
+{
+  sockets::bindOrDie(sockfd_, listenAddr.getSockAddr(), listenAddr.getSockLen());
+}
+
+UdpServer::~UdpServer()
+{
+  LOG_TRACE << "UdpServer::~UdpServer [" << name_ << "] destructing";
+  if (!socket_)
+  {
+    // never started, nobody owns it yet
+    sockets::close(sockfd_);
+  }
+}
+
+void UdpServer::start()
+{
+  loop_->assertInLoopThread();
+  assert(!socket_);
+  socket_.reset(new DatagramSocket(loop_, sockfd_, batchSize_, maxDatagramSize_));
+  socket_->setMessageCallback(messageCallback_);
+  socket_->start();
+}
+
+void UdpServer::send(const InetAddress& peer, const void* data, size_t len)
+{
+  send(peer, StringPiece(static_cast<const char*>(data), static_cast<int>(len)));
+}
+
+void UdpServer::send(const InetAddress& peer, const StringPiece& message)
+{
+  if (loop_->isInLoopThread())
+  {
+    assert(socket_);
+    socket_->send(peer.getSockAddr(), peer.getSockLen(), message.data(), message.size());
+  }
+  else
+  {
+    loop_->runInLoop(
+        boost::bind(&UdpServer::sendInLoop,
+                    this,     // FIXME
+                    peer,
+                    message.as_string()));
+  }
+}
+
+void UdpServer::sendInLoop(const InetAddress& peer, const string& message)
+{
+  loop_->assertInLoopThread();
+  assert(socket_);
+  socket_->send(peer.getSockAddr(), peer.getSockLen(), message.data(), message.size());
+}
+
+const DatagramStats& UdpServer::stats() const
+{
+  loop_->assertInLoopThread();
+  assert(socket_);
+  return socket_->stats();
+}
@@ -0,0 +1,86 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSERVER_H
+#define MUDUO_NET_UDPSERVER_H
+
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
+#include <muduo/net/Callbacks.h>
+#include <muduo/net/DatagramStats.h>
+#include <muduo/net/InetAddress.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class DatagramSocket;
+class EventLoop;
+
+///
+/// UDP server, receives and sends datagrams in batches of recvmmsg(2)
+/// and sendmmsg(2).
+///
+/// Replies sent from MessageCallback go out together after the batch.
+class UdpServer : boost::noncopyable
+{
+ public:
+  UdpServer(EventLoop* loop,
+            const InetAddress& listenAddr,
+            const string& nameArg);
+  ~UdpServer();  // force out-line dtor, for scoped_ptr members.
+
+  const string& name() const { return name_; }
+  EventLoop* getLoop() const { return loop_; }
+
+  /// Datagrams per recvmmsg(2), also the size of the send queue.
+  /// Must be called before start().
+  void setBatchSize(int batchSize) { batchSize_ = batchSize; }
+
+  /// Longer datagrams are truncated when received,
+  /// and sent one by one.
+  /// Must be called before start().
+  void setMaxDatagramSize(size_t size) { maxDatagramSize_ = size; }
+
+  /// Set message callback.
+  /// Not thread safe.
+  void setMessageCallback(const DatagramCallback& cb)
+  { messageCallback_ = cb; }
+
+  /// Starts receiving, in loop thread.
+  void start();
+
+  /// Thread safe, after start().
+  void send(const InetAddress& peer, const void* data, size_t len);
+  void send(const InetAddress& peer, const StringPiece& message);
+
+  /// In loop thread.
+  const DatagramStats& stats() const;
+
+ private:
+  void sendInLoop(const InetAddress& peer, const string& message);
+
+  EventLoop* loop_;
+  const string name_;
+  int sockfd_;
+  int batchSize_;
+  size_t maxDatagramSize_;
+  DatagramCallback messageCallback_;
+  boost::scoped_ptr<DatagramSocket> socket_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_UDPSERVER_H
@@ -9,10 +9,12 @@
 
 #include <muduo/net/inspect/Inspector.h>
 
+#include <muduo/base/AsyncLogging.h>
 #include <muduo/base/Thread.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/http/HttpRequest.h>
 #include <muduo/net/http/HttpResponse.h>
+#include <muduo/net/inspect/LoopInspector.h>
 #include <muduo/net/inspect/ProcessInspector.h>
 
 //#include <iostream>
@@ -53,19 +55,43 @@ std::vector<string> split(const string& str)
   return result;
 }
 
+string asyncLoggingStats(AsyncLogging* log, HttpRequest::Method, const Inspector::ArgList&)
+{
+  static const char* policies[] = { "drop_new", "block", "keep_warn", "sample" };
+  AsyncLogging::OverloadStats stats = log->overloadStats();
+  char buf[256];
+  snprintf(buf, sizeof buf, "policy %s, max buffers %d\nlevel  dropped_lines  dropped_bytes\n",
+           policies[log->overloadPolicy()], log->maxBuffers());
+  string result = buf;
+  for (int level = 0; level < Logger::NUM_LOG_LEVELS; ++level)
+  {
+    snprintf(buf, sizeof buf, "%s %13lld  %13lld\n", LogLevelName[level],
+             static_cast<long long>(stats.droppedLines[level]),
+             static_cast<long long>(stats.droppedBytes[level]));
+    result += buf;
+  }
+  snprintf(buf, sizeof buf, "blocked %lld times, %lld us\n",
+           static_cast<long long>(stats.blocked),
+           static_cast<long long>(stats.blockedMicros));
+  result += buf;
+  return result;
+}
+
 }
 
 Inspector::Inspector(EventLoop* loop,
                      const InetAddress& httpAddr,
                      const string& name)
     : server_(loop, httpAddr, "Inspector:"+name),
-      processInspector_(new ProcessInspector)
+      processInspector_(new ProcessInspector),
+      loopInspector_(new LoopInspector)
 {
   assert(CurrentThread::isMainThread());
   assert(g_globalInspector == 0);
   g_globalInspector = this;
   server_.setHttpCallback(boost::bind(&Inspector::onRequest, this, _1, _2));
   processInspector_->registerCommands(this);
+  loopInspector_->registerCommands(this);
   loop->runAfter(0, boost::bind(&Inspector::start, this)); // little race condition
 }
 
@@ -85,6 +111,22 @@ void Inspector::add(const string& module,
   helps_[module][command] = help;
 }
 
+void Inspector::addLoop(const string& name, EventLoop* loop)
+{
+  loopInspector_->addLoop(name, loop);
+}
+
+void Inspector::removeLoop(const string& name)
+{
+  loopInspector_->removeLoop(name);
+}
+
+void Inspector::addAsyncLogging(AsyncLogging* log)
+{
+  add("log", "stats", boost::bind(asyncLoggingStats, log, _1, _2),
+      "print log lines dropped by AsyncLogging");
+}
+
 void Inspector::start()
 {
   server_.start();
@@ -22,9 +22,12 @@
 
 namespace muduo
 {
+class AsyncLogging;
+
 namespace net
 {
 
+class LoopInspector;
 class ProcessInspector;
 
 // A internal inspector of the running process, usually a singleton.
@@ -43,6 +46,15 @@ class Inspector : boost::noncopyable
            const Callback& cb,
            const string& help);
 
+  /// Shows LoopStats of @c loop under /loop/stats/<name>.
+  /// Thread safe, eg. from ThreadInitCallback.
+  void addLoop(const string& name, EventLoop* loop);
+  /// Must be called before the loop is destroyed.  Thread safe.
+  void removeLoop(const string& name);
+
+  /// Shows lines dropped by @c log under /log/stats.
+  void addAsyncLogging(AsyncLogging* log);
+
  private:
   typedef std::map<string, Callback> CommandList;
   typedef std::map<string, string> HelpList;
@@ -52,6 +64,7 @@ class Inspector : boost::noncopyable
 
   HttpServer server_;
   boost::scoped_ptr<ProcessInspector> processInspector_;
+  boost::scoped_ptr<LoopInspector> loopInspector_;
   MutexLock mutex_;
   std::map<string, CommandList> commands_;
   std::map<string, HelpList> helps_;
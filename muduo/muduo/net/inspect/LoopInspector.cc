@@ -0,0 +1,89 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include <muduo/net/inspect/LoopInspector.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/LoopStats.h>
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+void LoopInspector::registerCommands(Inspector* ins)
+{
+  ins->add("loop", "list", boost::bind(&LoopInspector::list, this, _1, _2),
+           "list event loops");
+  ins->add("loop", "stats", boost::bind(&LoopInspector::stats, this, _1, _2),
+           "print time spent by event loops, /loop/stats/<name> for one");
+  ins->add("loop", "start", boost::bind(&LoopInspector::start, this, _1, _2),
+           "start timing event loops");
+  ins->add("loop", "stop", boost::bind(&LoopInspector::stop, this, _1, _2),
+           "stop timing event loops");
+}
+
+void LoopInspector::addLoop(const string& name, EventLoop* loop)
+{
+  MutexLockGuard lock(mutex_);
+  loops_[name] = loop;
+}
+
+void LoopInspector::removeLoop(const string& name)
+{
+  // commands hold mutex_ while using a loop
+  MutexLockGuard lock(mutex_);
+  loops_.erase(name);
+}
+
+string LoopInspector::list(HttpRequest::Method, const Inspector::ArgList&)
+{
+  string result;
+  MutexLockGuard lock(mutex_);
+  for (LoopMap::const_iterator it = loops_.begin(); it != loops_.end(); ++it)
+  {
+    result += it->first;
+    result += "\n";
+  }
+  return result;
+}
+
+string LoopInspector::stats(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  string result;
+  MutexLockGuard lock(mutex_);
+  for (LoopMap::const_iterator it = loops_.begin(); it != loops_.end(); ++it)
+  {
+    if (args.empty() || args[0] == it->first)
+    {
+      result += "[" + it->first + "]\n";
+      result += it->second->loopStats().toString();
+    }
+  }
+  return result;
+}
+
+string LoopInspector::start(HttpRequest::Method, const Inspector::ArgList&)
+{
+  MutexLockGuard lock(mutex_);
+  for (LoopMap::const_iterator it = loops_.begin(); it != loops_.end(); ++it)
+  {
+    it->second->setLoopStats(true);
+  }
+  return "started\n";
+}
+
+string LoopInspector::stop(HttpRequest::Method, const Inspector::ArgList&)
+{
+  MutexLockGuard lock(mutex_);
+  for (LoopMap::const_iterator it = loops_.begin(); it != loops_.end(); ++it)
+  {
+    it->second->setLoopStats(false);
+  }
+  return "stopped\n";
+}
@@ -0,0 +1,47 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+#define MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+
+#include <muduo/base/Mutex.h>
+#include <muduo/net/inspect/Inspector.h>
+#include <boost/noncopyable.hpp>
+
+#include <map>
+
+namespace muduo
+{
+namespace net
+{
+
+class LoopInspector : boost::noncopyable
+{
+ public:
+  void registerCommands(Inspector* ins);
+  void addLoop(const string& name, EventLoop* loop);
+  void removeLoop(const string& name);
+
+ private:
+  typedef std::map<string, EventLoop*> LoopMap;
+
+  string list(HttpRequest::Method, const Inspector::ArgList&);
+  string stats(HttpRequest::Method, const Inspector::ArgList& args);
+  string start(HttpRequest::Method, const Inspector::ArgList&);
+  string stop(HttpRequest::Method, const Inspector::ArgList&);
+
+  MutexLock mutex_;
+  LoopMap loops_;  // guarded by mutex_, removed before destroyed
+};
+
+}
+}
+
+#endif  // MUDUO_NET_INSPECT_LOOPINSPECTOR_H
@@ -7,8 +7,12 @@
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
 #include <muduo/net/Poller.h>
+#include <muduo/base/Logging.h>
 #include <muduo/net/poller/PollPoller.h>
 #include <muduo/net/poller/EPollPoller.h>
+#ifdef MUDUO_HAVE_IO_URING
+#include <muduo/net/poller/IoUringPoller.h>
+#endif
 
 #include <stdlib.h>
 
@@ -20,6 +24,19 @@ Poller* Poller::newDefaultPoller(EventLoop* loop)
   {
     return new PollPoller(loop);
   }
+  else if (::getenv("MUDUO_USE_IO_URING"))
+  {
+#ifdef MUDUO_HAVE_IO_URING
+    IoUringPoller* poller = new IoUringPoller(loop);
+    if (poller->ok())
+    {
+      return poller;
+    }
+    delete poller;
+#endif
+    LOG_WARN << "io_uring is not available, falling back to epoll";
+    return new EPollPoller(loop);
+  }
   else
   {
     return new EPollPoller(loop);
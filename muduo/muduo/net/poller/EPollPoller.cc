@@ -10,6 +10,7 @@
 
 #include <muduo/base/Logging.h>
 #include <muduo/net/Channel.h>
+#include <muduo/net/EventLoop.h>
 
 #include <boost/static_assert.hpp>
 
@@ -166,7 +167,18 @@ void EPollPoller::update(int operation, Channel* channel)
   struct epoll_event event;
   bzero(&event, sizeof event);
   event.events = channel->events();
+  if (channel->edgeTriggered())
+  {
+    // writing is registered once, Channel toggles it without epoll_ctl,
+    // EPOLLRDHUP tells a reader to drain until EOF, not one who stopped.
+    event.events |= EPOLLOUT | EPOLLET;
+    if (channel->isReading())
+    {
+      event.events |= EPOLLRDHUP;
+    }
+  }
   event.data.ptr = channel;
+  ++ownerLoop()->syscallStats().pollerUpdates;
   int fd = channel->fd();
   if (::epoll_ctl(epollfd_, operation, fd, &event) < 0)
   {
@@ -35,6 +35,7 @@ class EPollPoller : public Poller
   virtual Timestamp poll(int timeoutMs, ChannelList* activeChannels);
   virtual void updateChannel(Channel* channel);
   virtual void removeChannel(Channel* channel);
+  virtual bool supportsEdgeTriggered() const { return true; }
 
  private:
   static const int kInitEventListSize = 16;
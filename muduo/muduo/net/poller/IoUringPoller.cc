@@ -0,0 +1,422 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/poller/IoUringPoller.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/Channel.h>
+#include <muduo/net/EventLoop.h>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+const int kNew = -1;
+const int kAdded = 1;
+
+// cancellations and other fire-and-forget requests
+const uint64_t kIgnored = 0;
+
+int sys_io_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sys_io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete,
+                       unsigned flags, const void* arg, size_t argsz)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, arg, argsz));
+}
+
+// the kernel writes one side of each ring, we write the other
+unsigned loadAcquire(const unsigned* p)
+{
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void storeRelease(unsigned* p, unsigned v)
+{
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+template<typename T>
+T* offset(void* base, unsigned off)
+{
+  return reinterpret_cast<T*>(static_cast<char*>(base) + off);
+}
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+  : Poller(loop),
+    ringFd_(-1),
+    sqRing_(MAP_FAILED),
+    sqRingSize_(0),
+    cqRing_(MAP_FAILED),
+    cqRingSize_(0),
+    sqes_(NULL),
+    sqesSize_(0),
+    sqHead_(NULL),
+    sqTail_(NULL),
+    sqArray_(NULL),
+    sqMask_(0),
+    sqEntries_(0),
+    cqHead_(NULL),
+    cqTail_(NULL),
+    cqes_(NULL),
+    cqMask_(0),
+    sequence_(0)
+{
+  if (!setupRing())
+  {
+    LOG_SYSERR << "IoUringPoller::IoUringPoller";
+    closeRing();
+  }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+  closeRing();
+}
+
+void IoUringPoller::closeRing()
+{
+  if (sqes_)
+  {
+    ::munmap(sqes_, sqesSize_);
+    sqes_ = NULL;
+  }
+  if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+  {
+    ::munmap(cqRing_, cqRingSize_);
+  }
+  cqRing_ = MAP_FAILED;
+  if (sqRing_ != MAP_FAILED)
+  {
+    ::munmap(sqRing_, sqRingSize_);
+    sqRing_ = MAP_FAILED;
+  }
+  if (ringFd_ >= 0)
+  {
+    ::close(ringFd_);
+    ringFd_ = -1;
+  }
+}
+
+bool IoUringPoller::setupRing()
+{
+  struct io_uring_params params;
+  bzero(&params, sizeof params);
+  // plenty of room for completions, one per ready channel per iteration
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = kCqEntries;
+  ringFd_ = sys_io_uring_setup(kSqEntries, &params);
+  if (ringFd_ < 0)
+  {
+    return false;
+  }
+
+  // EXT_ARG: wait with a timeout in the same io_uring_enter(2) that submits.
+  // NODROP: completions are never lost, even if the CQ ring overflows.
+  const unsigned required = IORING_FEAT_EXT_ARG | IORING_FEAT_NODROP;
+  if ((params.features & required) != required)
+  {
+    errno = ENOSYS;
+    return false;
+  }
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = ::mmap(NULL, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+  if (sqRing_ == MAP_FAILED)
+  {
+    return false;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    cqRing_ = sqRing_;
+  }
+  else
+  {
+    cqRing_ = ::mmap(NULL, cqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+    if (cqRing_ == MAP_FAILED)
+    {
+      return false;
+    }
+  }
+  sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = ::mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    return false;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  sqHead_ = offset<unsigned>(sqRing_, params.sq_off.head);
+  sqTail_ = offset<unsigned>(sqRing_, params.sq_off.tail);
+  sqArray_ = offset<unsigned>(sqRing_, params.sq_off.array);
+  sqMask_ = *offset<unsigned>(sqRing_, params.sq_off.ring_mask);
+  sqEntries_ = *offset<unsigned>(sqRing_, params.sq_off.ring_entries);
+  cqHead_ = offset<unsigned>(cqRing_, params.cq_off.head);
+  cqTail_ = offset<unsigned>(cqRing_, params.cq_off.tail);
+  cqes_ = offset<struct io_uring_cqe>(cqRing_, params.cq_off.cqes);
+  cqMask_ = *offset<unsigned>(cqRing_, params.cq_off.ring_mask);
+  return true;
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+  // arm everything that fired or changed since last time,
+  // they go to the kernel together with the wait below.
+  std::vector<uint64_t> cancels;
+  cancels.swap(cancels_);
+  for (size_t i = 0; i < cancels.size(); ++i)
+  {
+    cancelPoll(cancels[i]);
+  }
+
+  std::vector<int> rearms;
+  rearms.swap(rearms_);
+  for (size_t i = 0; i < rearms.size(); ++i)
+  {
+    ChannelMap::iterator it = channels_.find(rearms[i]);
+    if (it != channels_.end() && it->second.rearming)
+    {
+      Registration& reg = it->second;
+      reg.rearming = false;
+      if (!reg.armed && !reg.channel->isNoneEvent())
+      {
+        armPoll(it->first, &reg);
+      }
+    }
+  }
+  rearms.clear();
+  if (rearms_.empty())
+  {
+    rearms_.swap(rearms);  // keep the capacity
+  }
+
+  int ret = enter(1, timeoutMs);
+  int savedErrno = errno;
+  Timestamp now(Timestamp::now());
+  size_t numEvents = activeChannels->size();
+  reapCompletions(activeChannels);
+  numEvents = activeChannels->size() - numEvents;
+  if (numEvents > 0)
+  {
+    LOG_TRACE << numEvents << " events happended";
+  }
+  else if (ret >= 0 || savedErrno == ETIME || savedErrno == EINTR)
+  {
+    LOG_TRACE << " nothing happended";
+  }
+  else
+  {
+    errno = savedErrno;
+    LOG_SYSERR << "IoUringPoller::poll()";
+  }
+  return now;
+}
+
+void IoUringPoller::reapCompletions(ChannelList* activeChannels)
+{
+  unsigned head = *cqHead_;
+  const unsigned tail = loadAcquire(cqTail_);
+  for (; head != tail; ++head)
+  {
+    const struct io_uring_cqe& cqe = cqes_[head & cqMask_];
+    if (cqe.user_data == kIgnored)
+    {
+      continue;
+    }
+    int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+    ChannelMap::iterator it = channels_.find(fd);
+    // a stale poll of a removed or re-registered channel
+    if (it == channels_.end() || it->second.armed != cqe.user_data)
+    {
+      continue;
+    }
+    Registration& reg = it->second;
+    reg.armed = 0;
+    if (cqe.res >= 0)
+    {
+      reg.channel->set_revents(cqe.res);
+      activeChannels->push_back(reg.channel);
+    }
+    else if (cqe.res != -ECANCELED)
+    {
+      errno = -cqe.res;
+      LOG_SYSERR << "IoUringPoller poll fd=" << fd;
+    }
+    scheduleRearm(fd, &reg);
+  }
+  storeRelease(cqHead_, head);
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  LOG_TRACE << "fd = " << channel->fd() << " events = " << channel->events();
+  const int fd = channel->fd();
+  if (channel->index() == kNew)
+  {
+    assert(channels_.find(fd) == channels_.end());
+    Registration& reg = channels_[fd];
+    reg.channel = channel;
+    reg.armed = 0;
+    reg.armedEvents = 0;
+    reg.rearming = false;
+    channel->set_index(kAdded);
+    scheduleRearm(fd, &reg);
+  }
+  else
+  {
+    assert(channel->index() == kAdded);
+    ChannelMap::iterator it = channels_.find(fd);
+    assert(it != channels_.end());
+    Registration& reg = it->second;
+    assert(reg.channel == channel);
+    if (reg.armed && reg.armedEvents != channel->events())
+    {
+      cancelPoll(reg.armed);
+      reg.armed = 0;
+    }
+    scheduleRearm(fd, &reg);
+  }
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  int fd = channel->fd();
+  LOG_TRACE << "fd = " << fd;
+  ChannelMap::iterator it = channels_.find(fd);
+  assert(it != channels_.end());
+  assert(it->second.channel == channel);
+  assert(channel->isNoneEvent());
+  if (it->second.armed)
+  {
+    cancelPoll(it->second.armed);
+  }
+  channels_.erase(it);
+  channel->set_index(kNew);
+}
+
+void IoUringPoller::scheduleRearm(int fd, Registration* reg)
+{
+  if (!reg->rearming && !reg->armed)
+  {
+    reg->rearming = true;
+    rearms_.push_back(fd);
+  }
+}
+
+struct io_uring_sqe* IoUringPoller::getSqe()
+{
+  unsigned tail = *sqTail_;
+  if (tail - loadAcquire(sqHead_) == sqEntries_)
+  {
+    // submission ring is full, hand it over without waiting
+    ++ownerLoop()->syscallStats().pollerUpdates;
+    if (enter(0, 0) < 0)
+    {
+      // EBUSY if completions are backlogged, until poll() reaps them
+      LOG_SYSERR << "IoUringPoller::getSqe()";
+    }
+    if (tail - loadAcquire(sqHead_) == sqEntries_)
+    {
+      return NULL;
+    }
+  }
+  unsigned index = tail & sqMask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  bzero(sqe, sizeof *sqe);
+  sqArray_[index] = index;
+  return sqe;
+}
+
+void IoUringPoller::armPoll(int fd, Registration* reg)
+{
+  if (++sequence_ == 0)
+  {
+    ++sequence_;
+  }
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == NULL)
+  {
+    scheduleRearm(fd, reg);
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = static_cast<uint32_t>(reg->channel->events());
+  sqe->user_data = (static_cast<uint64_t>(sequence_) << 32) | static_cast<uint32_t>(fd);
+  storeRelease(sqTail_, *sqTail_ + 1);
+  reg->armed = sqe->user_data;
+  reg->armedEvents = reg->channel->events();
+}
+
+void IoUringPoller::cancelPoll(uint64_t userData)
+{
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == NULL)
+  {
+    cancels_.push_back(userData);
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = userData;
+  sqe->user_data = kIgnored;
+  storeRelease(sqTail_, *sqTail_ + 1);
+}
+
+int IoUringPoller::enter(unsigned minComplete, int timeoutMs)
+{
+  unsigned toSubmit = *sqTail_ - loadAcquire(sqHead_);
+  unsigned flags = 0;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  bzero(&arg, sizeof arg);
+  if (minComplete > 0)
+  {
+    flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeoutMs >= 0)
+    {
+      ts.tv_sec = timeoutMs / 1000;
+      ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+      arg.ts = reinterpret_cast<uintptr_t>(&ts);
+    }
+  }
+  return sys_io_uring_enter(ringFd_, toSubmit, minComplete, flags,
+                            minComplete > 0 ? &arg : NULL,
+                            minComplete > 0 ? sizeof arg : 0);
+}
+
@@ -0,0 +1,99 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_POLLER_IOURINGPOLLER_H
+#define MUDUO_NET_POLLER_IOURINGPOLLER_H
+
+#include <muduo/net/Poller.h>
+
+#include <map>
+#include <vector>
+
+#include <stdint.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// IO Multiplexing with io_uring(7) poll requests.
+///
+/// Every channel has at most one one-shot IORING_OP_POLL_ADD in flight.
+/// Completed polls are armed again in the next poll(), so they are
+/// level-triggered like poll(2), and all registrations made during an
+/// iteration go to the kernel with the io_uring_enter(2) that waits.
+/// If the kernel takes no more submissions, eg. while completions are
+/// backlogged, they are retried in the next poll(), after reaping.
+class IoUringPoller : public Poller
+{
+ public:
+  IoUringPoller(EventLoop* loop);
+  virtual ~IoUringPoller();
+
+  /// false if the kernel lacks io_uring, or a feature we need.
+  bool ok() const { return ringFd_ >= 0; }
+
+  virtual Timestamp poll(int timeoutMs, ChannelList* activeChannels);
+  virtual void updateChannel(Channel* channel);
+  virtual void removeChannel(Channel* channel);
+
+ private:
+  static const unsigned kSqEntries = 1024;
+  static const unsigned kCqEntries = 16384;
+
+  struct Registration
+  {
+    Channel* channel;
+    uint64_t armed;  // user_data of the poll in flight, 0 if none
+    int armedEvents;
+    bool rearming;  // in rearms_
+  };
+
+  bool setupRing();
+  void closeRing();
+  // NULL if the ring stays full
+  struct io_uring_sqe* getSqe();
+  void armPoll(int fd, Registration* reg);
+  void cancelPoll(uint64_t userData);
+  void scheduleRearm(int fd, Registration* reg);
+  int enter(unsigned minComplete, int timeoutMs);
+  void reapCompletions(ChannelList* activeChannels);
+
+  typedef std::map<int, Registration> ChannelMap;
+
+  int ringFd_;
+  void* sqRing_;
+  size_t sqRingSize_;
+  void* cqRing_;
+  size_t cqRingSize_;
+  struct io_uring_sqe* sqes_;
+  size_t sqesSize_;
+  unsigned* sqHead_;
+  unsigned* sqTail_;
+  unsigned* sqArray_;
+  unsigned sqMask_;
+  unsigned sqEntries_;
+  unsigned* cqHead_;
+  unsigned* cqTail_;
+  struct io_uring_cqe* cqes_;
+  unsigned cqMask_;
+  uint32_t sequence_;  // high half of user_data, fd is the low half
+  ChannelMap channels_;
+  std::vector<int> rearms_;
+  std::vector<uint64_t> cancels_;  // found the ring full, retried in poll()
+};
+
+}
+}
+#endif  // MUDUO_NET_POLLER_IOURINGPOLLER_H
@@ -0,0 +1,127 @@
+// Connect storm against a TcpServer, measures accepts per second.
+//
+// Usage: acceptor_bench [max accepts per read] [io threads] [client threads]
+//                       [connections per client] [reuseport]
+//
+// Each client thread connects and closes immediately, as fast as it can.
+
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/SocketsOps.h>
+#include <muduo/net/TcpServer.h>
+#include <muduo/base/Atomic.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+class Bench
+{
+ public:
+  Bench(EventLoop* loop, const InetAddress& listenAddr,
+        int maxAccepts, int ioThreads, int numClients, int connections,
+        TcpServer::Option option)
+    : loop_(loop),
+      listenAddr_(listenAddr),
+      server_(loop, listenAddr, "AcceptorBench", option),
+      connections_(connections),
+      expected_(numClients * connections)
+  {
+    server_.setMaxAcceptsPerRead(maxAccepts);
+    server_.setThreadNum(ioThreads);
+    server_.setConnectionCallback(
+        boost::bind(&Bench::onConnection, this, _1));
+    for (int i = 0; i < numClients; ++i)
+    {
+      char name[32];
+      snprintf(name, sizeof name, "client %d", i);
+      clients_.push_back(new muduo::Thread(
+            boost::bind(&Bench::clientFunc, this), muduo::string(name)));
+    }
+  }
+
+  void run()
+  {
+    server_.start();
+    int64_t iteration = loop_->iteration();
+    Timestamp start(Timestamp::now());
+    for_each(clients_.begin(), clients_.end(), boost::bind(&muduo::Thread::start, _1));
+    loop_->loop();
+    double seconds = timeDifference(Timestamp::now(), start);
+    for_each(clients_.begin(), clients_.end(), boost::bind(&muduo::Thread::join, _1));
+
+    int64_t iterations = loop_->iteration() - iteration;
+    printf("%d connections, %.3f seconds, %.0f accepts/s, "
+           "%lld loop iterations, %.1f accepts per iteration, %d failed connects\n",
+           expected_, seconds, expected_ / seconds,
+           static_cast<long long>(iterations),
+           static_cast<double>(expected_) / static_cast<double>(iterations),
+           failed_.get());
+  }
+
+ private:
+  void clientFunc()
+  {
+    for (int i = 0; i < connections_; ++i)
+    {
+      int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+      if (sockfd < 0)
+      {
+        LOG_SYSFATAL << "socket";
+      }
+      while (sockets::connect(sockfd, listenAddr_.getSockAddr(), listenAddr_.getSockLen()) < 0)
+      {
+        // a full backlog is retried by the kernel, anything else by us
+        failed_.increment();
+        ::close(sockfd);
+        sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+      }
+      ::close(sockfd);
+    }
+  }
+
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected() && accepted_.incrementAndGet() == expected_)
+    {
+      loop_->quit();
+    }
+  }
+
+  EventLoop* loop_;
+  InetAddress listenAddr_;
+  TcpServer server_;
+  boost::ptr_vector<muduo::Thread> clients_;
+  const int connections_;
+  const int expected_;
+  AtomicInt32 accepted_;
+  AtomicInt32 failed_;
+};
+
+int main(int argc, char* argv[])
+{
+  int maxAccepts = argc > 1 ? atoi(argv[1]) : 1;
+  int ioThreads = argc > 2 ? atoi(argv[2]) : 4;
+  int clients = argc > 3 ? atoi(argv[3]) : 8;
+  int connections = argc > 4 ? atoi(argv[4]) : 10000;
+  TcpServer::Option option = argc > 5 && strcmp(argv[5], "reuseport") == 0
+      ? TcpServer::kReusePort : TcpServer::kNoReusePort;
+
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  InetAddress listenAddr("127.0.0.1", 2013);
+  Bench bench(&loop, listenAddr, maxAccepts, ioThreads, clients, connections, option);
+  bench.run();
+}
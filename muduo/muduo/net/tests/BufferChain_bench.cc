@@ -0,0 +1,222 @@
+// Compares the copying cost of the old contiguous output Buffer
+// with BufferChain, under bursty output to a slow reader.
+//
+// The writer queues bursts of small messages and large Buffers,
+// as TcpConnection::send() does, the reader drains at a fixed rate.
+
+#include <muduo/net/Buffer.h>
+#include <muduo/net/BufferChain.h>
+#include <muduo/base/Timestamp.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int kRounds = 2000;
+const int kBurstRounds = 10;   // then kBurstRounds quiet rounds
+const int kSmallMessages = 128;
+const size_t kSmallSize = 100;
+const int kLargeMessages = 4;
+const size_t kLargeSize = 64*1024;
+const size_t kDrainPerRound = 256*1024;
+
+struct Stat
+{
+  Stat() : sent(0), copied(0), peak(0) { }
+  size_t sent;
+  size_t copied;
+  size_t peak;
+};
+
+class OldOutput
+{
+ public:
+  explicit OldOutput(int fd) : fd_(fd) { }
+
+  void send(const char* data, size_t len)
+  {
+    size_t nwrote = 0;
+    if (output_.readableBytes() == 0)
+    {
+      ssize_t n = ::write(fd_, data, len);
+      nwrote = n > 0 ? n : 0;
+    }
+    if (nwrote < len)
+    {
+      // Buffer::makeSpace() moves or reallocates what's queued
+      if (output_.writableBytes() < len - nwrote)
+      {
+        stat_.copied += output_.readableBytes();
+      }
+      output_.append(data+nwrote, len-nwrote);
+      stat_.copied += len-nwrote;
+    }
+    stat_.sent += len;
+    stat_.peak = std::max(stat_.peak, output_.readableBytes());
+  }
+
+  void send(Buffer* buf)
+  {
+    send(buf->peek(), buf->readableBytes());
+    buf->retrieveAll();
+  }
+
+  void handleWrite()
+  {
+    if (output_.readableBytes() > 0)
+    {
+      ssize_t n = ::write(fd_, output_.peek(), output_.readableBytes());
+      if (n > 0)
+      {
+        output_.retrieve(n);
+      }
+    }
+  }
+
+  size_t queued() const { return output_.readableBytes(); }
+  const Stat& stat() const { return stat_; }
+
+ private:
+  int fd_;
+  Buffer output_;
+  Stat stat_;
+};
+
+class ChainOutput
+{
+ public:
+  explicit ChainOutput(int fd) : fd_(fd) { }
+
+  void send(const char* data, size_t len)
+  {
+    size_t nwrote = 0;
+    if (output_.readableBytes() == 0)
+    {
+      ssize_t n = ::write(fd_, data, len);
+      nwrote = n > 0 ? n : 0;
+    }
+    if (nwrote < len)
+    {
+      output_.append(data+nwrote, len-nwrote);
+      stat_.copied += len-nwrote;
+    }
+    stat_.sent += len;
+    stat_.peak = std::max(stat_.peak, output_.readableBytes());
+  }
+
+  void send(Buffer* buf)
+  {
+    size_t len = buf->readableBytes();
+    if (output_.readableBytes() == 0)
+    {
+      ssize_t n = ::write(fd_, buf->peek(), len);
+      if (n > 0)
+      {
+        buf->retrieve(n);
+      }
+    }
+    if (buf->readableBytes() > 0)
+    {
+      if (buf->readableBytes() < BufferChain::kCopyThreshold)
+      {
+        stat_.copied += buf->readableBytes();
+      }
+      output_.append(buf);
+    }
+    stat_.sent += len;
+    stat_.peak = std::max(stat_.peak, output_.readableBytes());
+  }
+
+  void handleWrite()
+  {
+    if (output_.readableBytes() > 0)
+    {
+      int savedErrno = 0;
+      output_.writeFd(fd_, &savedErrno);
+    }
+  }
+
+  size_t queued() const { return output_.readableBytes(); }
+  const Stat& stat() const { return stat_; }
+
+ private:
+  int fd_;
+  BufferChain output_;
+  Stat stat_;
+};
+
+void drain(int fd, size_t maxBytes)
+{
+  static char buf[64*1024];
+  size_t total = 0;
+  while (total < maxBytes)
+  {
+    ssize_t n = ::read(fd, buf, std::min(sizeof buf, maxBytes - total));
+    if (n <= 0)
+      break;
+    total += n;
+  }
+}
+
+template<typename Output>
+void bench(const char* name)
+{
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+  {
+    perror("socketpair");
+    abort();
+  }
+  ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+  ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+  Output output(fds[0]);
+  string small(kSmallSize, 's');
+  Buffer large;
+
+  Timestamp start(Timestamp::now());
+  for (int round = 0; round < kRounds; ++round)
+  {
+    if ((round / kBurstRounds) % 2 == 0)
+    {
+      for (int i = 0; i < kSmallMessages; ++i)
+      {
+        output.send(small.data(), small.size());
+        if (i % (kSmallMessages / kLargeMessages) == 0)
+        {
+          large.append(string(kLargeSize, 'l'));
+          output.send(&large);
+        }
+      }
+    }
+    output.handleWrite();
+    drain(fds[1], kDrainPerRound);
+  }
+  while (output.queued() > 0)
+  {
+    output.handleWrite();
+    drain(fds[1], kDrainPerRound);
+  }
+  double seconds = timeDifference(Timestamp::now(), start);
+
+  const Stat& stat = output.stat();
+  printf("%-12s sent %zd bytes, copied %zd bytes, %.3f copied per byte sent, "
+         "peak queued %zd bytes, %.3f seconds\n",
+         name, stat.sent, stat.copied,
+         static_cast<double>(stat.copied) / static_cast<double>(stat.sent),
+         stat.peak, seconds);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+int main()
+{
+  bench<OldOutput>("Buffer");
+  bench<ChainOutput>("BufferChain");
+}
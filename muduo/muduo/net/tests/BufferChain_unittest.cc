@@ -0,0 +1,217 @@
+#include <muduo/net/BufferChain.h>
+#include <muduo/net/Buffer.h>
+
+//#define BOOST_TEST_MODULE BufferChainTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using muduo::string;
+using muduo::net::Buffer;
+using muduo::net::BufferChain;
+
+namespace
+{
+
+string readAll(int fd, size_t len)
+{
+  string result;
+  char buf[4096];
+  while (result.size() < len)
+  {
+    ssize_t n = ::read(fd, buf, sizeof buf);
+    if (n <= 0)
+      break;
+    result.append(buf, n);
+  }
+  return result;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainAppendRetrieve)
+{
+  BufferChain chain;
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 0);
+
+  chain.append(string(200, 'x'));
+  chain.append(string(300, 'y'));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 500);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 1);
+
+  chain.retrieve(250);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 250);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 1);
+
+  // still appendable in place after a partial retrieve
+  chain.append(string(100, 'z'));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 350);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 1);
+
+  chain.retrieve(350);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainNewBlock)
+{
+  BufferChain chain;
+  chain.append(string(BufferChain::kBlockSize - 10, 'x'));
+  BOOST_CHECK_EQUAL(chain.numSlices(), 1);
+
+  // doesn't fit, starts a new block instead of moving data
+  chain.append(string(100, 'y'));
+  BOOST_CHECK_EQUAL(chain.numSlices(), 2);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), BufferChain::kBlockSize + 90);
+
+  chain.append(string(2*BufferChain::kBlockSize, 'z'));
+  BOOST_CHECK_EQUAL(chain.numSlices(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainAppendBuffer)
+{
+  BufferChain chain;
+  Buffer small;
+  small.append(string(100, 's'));
+  chain.append(&small);
+  BOOST_CHECK_EQUAL(small.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 1);
+
+  Buffer large;
+  large.append(string(10000, 'l'));
+  const char* data = large.peek();
+  chain.append(&large);
+  BOOST_CHECK_EQUAL(large.readableBytes(), 0);
+  BOOST_CHECK(large.peek() != data);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 2);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 10100);
+
+  // won't append after a linked slice in place
+  chain.append(string(10, 't'));
+  BOOST_CHECK_EQUAL(chain.numSlices(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainShared)
+{
+  boost::shared_ptr<string> payload(new string(5000, 'p'));
+  BufferChain chain1;
+  BufferChain chain2;
+  chain1.append(payload, payload->data(), payload->size());
+  chain2.append(payload, payload->data(), payload->size());
+  BOOST_CHECK_EQUAL(payload.use_count(), 3);
+
+  chain1.retrieveAll();
+  BOOST_CHECK_EQUAL(payload.use_count(), 2);
+  chain2.retrieve(4999);
+  BOOST_CHECK_EQUAL(payload.use_count(), 2);
+  chain2.retrieve(1);
+  BOOST_CHECK_EQUAL(payload.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainWriteFd)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  BufferChain chain;
+  chain.append(string(100, 'a'));
+  Buffer large;
+  large.append(string(2000, 'b'));
+  chain.append(&large);
+  chain.append(string(100, 'c'));
+  BOOST_CHECK_EQUAL(chain.numSlices(), 3);
+
+  int savedErrno = 0;
+  ssize_t n = chain.writeFd(fds[0], &savedErrno);
+  BOOST_CHECK_EQUAL(n, 2200);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 0);
+
+  string expected = string(100, 'a') + string(2000, 'b') + string(100, 'c');
+  BOOST_CHECK(readAll(fds[1], expected.size()) == expected);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainFrame)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  boost::shared_ptr<string> body(new string(10000, 'b'));
+  BufferChain frame;
+  frame.append(body, body->data(), body->size());
+  frame.append("trailer", 7);
+  frame.prepend("head", 4);
+  BOOST_CHECK_EQUAL(frame.numSlices(), 3);
+  BOOST_CHECK_EQUAL(frame.readableBytes(), 10011);
+
+  BufferChain output;
+  output.append("queued ", 7);
+  output.append(&frame);
+  BOOST_CHECK_EQUAL(frame.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(frame.numSlices(), 0);
+  BOOST_CHECK_EQUAL(output.numSlices(), 4);
+  BOOST_CHECK_EQUAL(output.readableBytes(), 10018);
+  BOOST_CHECK_EQUAL(body.use_count(), 2);
+
+  // the trailer block is the tail now, small appends go there
+  output.append("!", 1);
+  BOOST_CHECK_EQUAL(output.numSlices(), 4);
+
+  int savedErrno = 0;
+  ssize_t n = output.writeFd(fds[0], &savedErrno);
+  BOOST_CHECK_EQUAL(n, 10019);
+  BOOST_CHECK_EQUAL(body.use_count(), 1);
+
+  string expected = "queued head" + *body + "trailer!";
+  BOOST_CHECK(readAll(fds[1], expected.size()) == expected);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainFile)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  FILE* fp = ::tmpfile();
+  BOOST_REQUIRE(fp != NULL);
+  string content = string(1000, 'f') + string(1000, 'g');
+  BOOST_REQUIRE_EQUAL(::write(fileno(fp), content.data(), content.size()),
+                      static_cast<ssize_t>(content.size()));
+
+  BufferChain chain;
+  chain.append(string(10, 'h'));
+  chain.appendFile(fileno(fp), 500, 1000);
+  chain.append(string(10, 't'));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 1020);
+  BOOST_CHECK_EQUAL(chain.fileBytes(), 1000);
+
+  // header, then the file region, then the trailer
+  int savedErrno = 0;
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 10);
+  chain.retrieve(300);
+  BOOST_CHECK_EQUAL(chain.fileBytes(), 700);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 700);
+  BOOST_CHECK_EQUAL(chain.fileBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 10);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+
+  string expected = string(10, 'h') + content.substr(800, 700) + string(10, 't');
+  BOOST_CHECK(readAll(fds[1], expected.size()) == expected);
+
+  // beyond the end of file
+  chain.appendFile(fileno(fp), 2000, 10);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 0);
+
+  ::fclose(fp);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
@@ -0,0 +1,73 @@
+#include <muduo/net/BufferPool.h>
+
+//#define BOOST_TEST_MODULE BufferPoolTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::net::Buffer;
+using muduo::net::BufferPool;
+
+BOOST_AUTO_TEST_CASE(testBufferPoolScratch)
+{
+  BufferPool pool;
+  Buffer* scratch = pool.scratch();
+  BOOST_CHECK_EQUAL(scratch->readableBytes(), 0);
+  BOOST_CHECK_GE(scratch->writableBytes(), BufferPool::kScratchSize);
+
+  // storage swapped away, eg. by TcpConnection::send(Buffer*)
+  Buffer small;
+  scratch->swap(small);
+  BOOST_CHECK(pool.scratch() == scratch);
+  BOOST_CHECK_GE(scratch->writableBytes(), BufferPool::kScratchSize);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolReleaseAcquire)
+{
+  BufferPool pool;
+  Buffer buf;
+  buf.append(string(10000, 'x'));
+  buf.retrieveAll();
+  size_t capacity = buf.internalCapacity();
+  BOOST_CHECK_GE(capacity, 10000);
+
+  pool.release(&buf);
+  BOOST_CHECK_LE(buf.internalCapacity(), Buffer::kCheapPrepend);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(pool.numPooled(), 1);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), capacity);
+
+  // nothing left to take
+  pool.release(&buf);
+  BOOST_CHECK_EQUAL(pool.numPooled(), 1);
+
+  Buffer other(0);
+  pool.acquire(&other);
+  BOOST_CHECK_EQUAL(other.internalCapacity(), capacity);
+  BOOST_CHECK_EQUAL(other.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(pool.numPooled(), 0);
+  BOOST_CHECK_EQUAL(pool.pooledBytes(), 0);
+
+  // already has storage
+  Buffer third;
+  pool.release(&other);
+  pool.acquire(&third);
+  BOOST_CHECK_EQUAL(pool.numPooled(), 1);
+  third.append("hello");
+  BOOST_CHECK_EQUAL(third.retrieveAllAsString(), "hello");
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolLimit)
+{
+  BufferPool pool;
+  size_t released = 0;
+  while (released <= BufferPool::kMaxPooledBytes)
+  {
+    Buffer buf(1024*1024);
+    released += buf.internalCapacity();
+    pool.release(&buf);
+  }
+  BOOST_CHECK_LE(pool.pooledBytes(), BufferPool::kMaxPooledBytes);
+  BOOST_CHECK_LT(pool.numPooled(), released / (1024*1024));
+}
@@ -0,0 +1,96 @@
+#include <muduo/net/DatagramSocket.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+//#define BOOST_TEST_MODULE DatagramSocketTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::Timestamp;
+using muduo::net::DatagramSocket;
+using muduo::net::EventLoop;
+using muduo::net::InetAddress;
+
+namespace
+{
+
+const int kMessages = 10;
+
+int g_received = 0;
+
+void onMessage(EventLoop* loop, const InetAddress&, const char*, size_t len, Timestamp)
+{
+  BOOST_CHECK_EQUAL(len, 5);
+  if (++g_received == kMessages)
+  {
+    loop->quit();
+  }
+}
+
+int createBound(const InetAddress& addr)
+{
+  int sockfd = muduo::net::sockets::createNonblockingUdpOrDie(addr.family());
+  muduo::net::sockets::bindOrDie(sockfd, addr.getSockAddr(), addr.getSockLen());
+  return sockfd;
+}
+
+void sendAll(DatagramSocket* sender, const InetAddress* peer)
+{
+  for (int i = 0; i < kMessages; ++i)
+  {
+    sender->send(peer->getSockAddr(), peer->getSockLen(), "hello", 5);
+  }
+  // queued until the end of this iteration
+  BOOST_CHECK_EQUAL(sender->stats().sendCalls, 0);
+}
+
+void sendAndDestroy(boost::scoped_ptr<DatagramSocket>* sender, const InetAddress* peer)
+{
+  (*sender)->send(peer->getSockAddr(), peer->getSockLen(), "hello", 5);
+  // the queued flush must not touch it
+  sender->reset();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(testSendBatching)
+{
+  EventLoop loop;
+  InetAddress receiverAddr("127.0.0.1", 20170);
+  DatagramSocket receiver(&loop, createBound(receiverAddr), 32, 1024);
+  receiver.setMessageCallback(boost::bind(onMessage, &loop, _1, _2, _3, _4));
+  receiver.start();
+
+  DatagramSocket sender(&loop, createBound(InetAddress("127.0.0.1", 20171)), 32, 1024);
+  sender.start();
+  // in a callback of the loop, flushed at the end of the iteration
+  loop.runAfter(0.0, boost::bind(sendAll, &sender, &receiverAddr));
+  loop.runAfter(10.0, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+
+  BOOST_CHECK_EQUAL(g_received, kMessages);
+  // all in one sendmmsg(2)
+  BOOST_CHECK_EQUAL(sender.stats().sendCalls, 1);
+  BOOST_CHECK_EQUAL(sender.stats().datagramsSent, kMessages);
+  BOOST_CHECK_EQUAL(sender.stats().datagramsDropped, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testDestroyedBeforeFlush)
+{
+  EventLoop loop;
+  InetAddress receiverAddr("127.0.0.1", 20172);
+  boost::scoped_ptr<DatagramSocket> sender(
+      new DatagramSocket(&loop, createBound(InetAddress("127.0.0.1", 20173)), 32, 1024));
+  sender->start();
+  loop.runAfter(0.0, boost::bind(sendAndDestroy, &sender, &receiverAddr));
+  loop.runAfter(0.1, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+
+  BOOST_CHECK(!sender);
+}
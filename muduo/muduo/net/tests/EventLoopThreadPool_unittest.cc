@@ -1,5 +1,6 @@
 #include <muduo/net/EventLoopThreadPool.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
 #include <muduo/base/Thread.h>
 
 #include <boost/bind.hpp>
@@ -64,6 +65,49 @@ int main()
     assert(nextLoop == model.getNextLoop());
   }
 
+  {
+    printf("Selection policies:\n");
+    EventLoopThreadPool model(&loop);
+    model.setThreadNum(3);
+    model.start(init);
+    std::vector<EventLoop*> loops = model.getAllLoops();
+    InetAddress peer("10.0.0.1", 1234), peer2("10.0.0.1", 4321);
+    loops[0]->addConnections(2);
+    loops[1]->addConnections(1);
+    loops[2]->addConnections(3);
+    loops[0]->addPendingOutputBytes(10);
+    loops[1]->addPendingOutputBytes(1000);
+
+    model.setSelectionPolicy(EventLoopThreadPool::kLeastConnections);
+    assert(model.getLoopForConnection(peer) == loops[1]);
+    model.setSelectionPolicy(EventLoopThreadPool::kLeastPendingBytes);
+    assert(model.getLoopForConnection(peer) == loops[2]);
+    model.setSelectionPolicy(EventLoopThreadPool::kPowerOfTwoChoices);
+    for (int i = 0; i < 100; ++i)
+    {
+      // never the busiest one
+      assert(model.getLoopForConnection(peer) != loops[2]);
+    }
+    model.setSelectionPolicy(EventLoopThreadPool::kHashByPeerAddress);
+    assert(model.getLoopForConnection(peer) == model.getLoopForConnection(peer2));
+
+    loops[0]->addConnections(-2);
+    loops[1]->addConnections(-1);
+    loops[2]->addConnections(-3);
+    loops[0]->addPendingOutputBytes(-10);
+    loops[1]->addPendingOutputBytes(-1000);
+  }
+
+  {
+    printf("Loop quit before the pool:\n");
+    EventLoopThreadPool model(&loop);
+    model.setThreadNum(1);
+    model.start(init);
+    EventLoop* nextLoop = model.getNextLoop();
+    nextLoop->runInLoop(boost::bind(&EventLoop::quit, nextLoop));
+    ::usleep(100*1000);
+  }
+
   loop.loop();
 }
 
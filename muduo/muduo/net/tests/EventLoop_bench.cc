@@ -0,0 +1,116 @@
+// Posts functors to one EventLoop from many threads,
+// measures throughput, wakeups and post-to-run latency.
+//
+// Usage: eventloop_bench [threads] [posts per thread]
+
+#include <muduo/net/EventLoop.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+class Bench
+{
+ public:
+  Bench(EventLoop* loop, int numThreads, int posts)
+    : loop_(loop),
+      latch_(numThreads),
+      threads_(numThreads),
+      posts_(posts),
+      expected_(static_cast<int64_t>(numThreads) * posts),
+      received_(0),
+      delays_(32)
+  {
+    for (int i = 0; i < numThreads; ++i)
+    {
+      char name[32];
+      snprintf(name, sizeof name, "post thread %d", i);
+      threads_.push_back(new muduo::Thread(
+            boost::bind(&Bench::threadFunc, this), muduo::string(name)));
+    }
+  }
+
+  void run()
+  {
+    int64_t iteration = loop_->iteration();
+    for_each(threads_.begin(), threads_.end(), boost::bind(&muduo::Thread::start, _1));
+    latch_.wait();
+    start_ = Timestamp::now();
+    loop_->loop();
+    double seconds = timeDifference(Timestamp::now(), start_);
+    for_each(threads_.begin(), threads_.end(), boost::bind(&muduo::Thread::join, _1));
+
+    int64_t wakeups = loop_->iteration() - iteration;
+    printf("%zd threads, %lld posts, %.3f seconds, %.0f posts/s, "
+           "%lld loop iterations, %.1f posts per iteration\n",
+           threads_.size(), static_cast<long long>(received_), seconds,
+           static_cast<double>(received_) / seconds,
+           static_cast<long long>(wakeups),
+           static_cast<double>(received_) / static_cast<double>(wakeups));
+    int64_t sum = 0;
+    for (size_t i = 0; i < delays_.size(); ++i)
+    {
+      if (delays_[i] > 0)
+      {
+        sum += delays_[i];
+        printf("delay < %8d us, count = %10lld, %6.2f%%\n",
+               1 << i, static_cast<long long>(delays_[i]),
+               100.0 * static_cast<double>(sum) / static_cast<double>(received_));
+      }
+    }
+  }
+
+ private:
+  void threadFunc()
+  {
+    latch_.countDown();
+    latch_.wait();
+    for (int i = 0; i < posts_; ++i)
+    {
+      loop_->queueInLoop(boost::bind(&Bench::received, this, Timestamp::now()));
+    }
+  }
+
+  // in loop thread
+  void received(Timestamp posted)
+  {
+    int64_t delay = Timestamp::now().microSecondsSinceEpoch() - posted.microSecondsSinceEpoch();
+    size_t bucket = 0;
+    while (delay >= (1 << bucket) && bucket < delays_.size() - 1)
+    {
+      ++bucket;
+    }
+    ++delays_[bucket];
+    if (++received_ == expected_)
+    {
+      loop_->quit();
+    }
+  }
+
+  EventLoop* loop_;
+  CountDownLatch latch_;
+  boost::ptr_vector<muduo::Thread> threads_;
+  const int posts_;
+  const int64_t expected_;
+  int64_t received_;
+  Timestamp start_;
+  std::vector<int64_t> delays_;  // power of 2 buckets
+};
+
+int main(int argc, char* argv[])
+{
+  int threads = argc > 1 ? atoi(argv[1]) : 4;
+  int posts = argc > 2 ? atoi(argv[2]) : 500000;
+
+  EventLoop loop;
+  Bench t(&loop, threads, posts);
+  t.run();
+}
@@ -1,5 +1,7 @@
 #include <muduo/net/InetAddress.h>
 
+#include <string.h>
+
 //#define BOOST_TEST_MODULE InetAddressTest
 #define BOOST_TEST_MAIN
 #define BOOST_TEST_DYN_LINK
@@ -22,3 +24,35 @@ BOOST_AUTO_TEST_CASE(testInetAddress)
   BOOST_CHECK_EQUAL(addr3.toIp(), string("255.255.255.255"));
   BOOST_CHECK_EQUAL(addr3.toIpPort(), string("255.255.255.255:65535"));
 }
+
+BOOST_AUTO_TEST_CASE(testInet6Address)
+{
+  InetAddress addr1(1234, true);
+  BOOST_CHECK_EQUAL(addr1.family(), AF_INET6);
+  BOOST_CHECK_EQUAL(addr1.toIp(), string("::"));
+  BOOST_CHECK_EQUAL(addr1.toIpPort(), string("[::]:1234"));
+
+  InetAddress addr2("1:2:3:4:5:6:7:8", 8888);
+  BOOST_CHECK_EQUAL(addr2.family(), AF_INET6);
+  BOOST_CHECK_EQUAL(addr2.toIp(), string("1:2:3:4:5:6:7:8"));
+  BOOST_CHECK_EQUAL(addr2.toIpPort(), string("[1:2:3:4:5:6:7:8]:8888"));
+  BOOST_CHECK_EQUAL(addr2.getSockLen(), sizeof(struct sockaddr_in6));
+
+  InetAddress addr3("::1", 65535);
+  BOOST_CHECK_EQUAL(addr3.toIpPort(), string("[::1]:65535"));
+  BOOST_CHECK(addr3.ipHash() != addr2.ipHash());
+}
+
+BOOST_AUTO_TEST_CASE(testUnixDomainAddress)
+{
+  InetAddress addr = InetAddress::unixDomain("/tmp/muduo.sock");
+  BOOST_CHECK_EQUAL(addr.family(), AF_UNIX);
+  BOOST_CHECK_EQUAL(addr.toIp(), string("/tmp/muduo.sock"));
+  BOOST_CHECK_EQUAL(addr.toIpPort(), string("/tmp/muduo.sock"));
+  BOOST_CHECK_EQUAL(addr.portNetEndian(), 0);
+
+  struct sockaddr_storage storage;
+  memcpy(&storage, addr.getSockAddr(), addr.getSockLen());
+  InetAddress copy(storage);
+  BOOST_CHECK_EQUAL(copy.toIpPort(), string("/tmp/muduo.sock"));
+}
@@ -0,0 +1,118 @@
+#include <muduo/net/SlabAllocator.h>
+
+//#define BOOST_TEST_MODULE SlabAllocatorTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
+
+using muduo::net::LoopAllocator;
+using muduo::net::SlabAllocator;
+
+namespace
+{
+
+int g_live = 0;
+
+struct Object
+{
+  Object(int a, int b) : sum(a + b) { ++g_live; }
+  ~Object() { --g_live; }
+  int sum;
+  char payload[200];
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(testSlabAllocatorRecycle)
+{
+  SlabAllocator slab;
+  void* p = slab.allocate(100);
+  void* q = slab.allocate(100);
+  BOOST_CHECK(p != q);
+  BOOST_CHECK_EQUAL(slab.numBlocksInUse(), 2);
+  BOOST_CHECK_EQUAL(slab.bytesReserved(), SlabAllocator::kChunkSize);
+
+  slab.deallocate(p, 100);
+  BOOST_CHECK_EQUAL(slab.numBlocksInUse(), 1);
+  // same size class, the freed block comes back
+  BOOST_CHECK(slab.allocate(112) == p);
+  void* r = slab.allocate(200);
+  BOOST_CHECK(r != p);
+  BOOST_CHECK(r != q);
+
+  slab.deallocate(p, 112);
+  slab.deallocate(q, 100);
+  slab.deallocate(r, 200);
+  BOOST_CHECK_EQUAL(slab.numBlocksInUse(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testSlabAllocatorZeroSize)
+{
+  SlabAllocator slab;
+  void* p = slab.allocate(0);
+  void* q = slab.allocate(0);
+  BOOST_CHECK(p != NULL);
+  BOOST_CHECK(q != NULL);
+  BOOST_CHECK(p != q);
+  slab.deallocate(p, 0);
+  // the smallest size class
+  BOOST_CHECK(slab.allocate(SlabAllocator::kAlignment) == p);
+  slab.deallocate(p, SlabAllocator::kAlignment);
+  slab.deallocate(q, 0);
+  BOOST_CHECK_EQUAL(slab.numBlocksInUse(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testSlabAllocatorLargeBlock)
+{
+  SlabAllocator slab;
+  void* p = slab.allocate(SlabAllocator::kMaxBlockSize + 1);
+  BOOST_CHECK_EQUAL(slab.numBlocksInUse(), 0);
+  BOOST_CHECK_EQUAL(slab.bytesReserved(), 0);
+  slab.deallocate(p, SlabAllocator::kMaxBlockSize + 1);
+}
+
+BOOST_AUTO_TEST_CASE(testSlabAllocatorChunks)
+{
+  SlabAllocator slab;
+  const size_t kBlocks = 2 * SlabAllocator::kChunkSize / SlabAllocator::kMaxBlockSize;
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < kBlocks; ++i)
+  {
+    blocks.push_back(slab.allocate(SlabAllocator::kMaxBlockSize));
+  }
+  BOOST_CHECK_EQUAL(slab.bytesReserved(), 2 * SlabAllocator::kChunkSize);
+  for (size_t i = 0; i < kBlocks; ++i)
+  {
+    slab.deallocate(blocks[i], SlabAllocator::kMaxBlockSize);
+  }
+  BOOST_CHECK_EQUAL(slab.numBlocksInUse(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testLoopAllocatorSharedPtr)
+{
+  boost::shared_ptr<SlabAllocator> slab(new SlabAllocator);
+  boost::weak_ptr<SlabAllocator> weakSlab(slab);
+  boost::shared_ptr<Object> obj = boost::allocate_shared<Object>(
+      LoopAllocator<Object>(slab), 1, 2);
+  BOOST_CHECK_EQUAL(obj->sum, 3);
+  BOOST_CHECK_EQUAL(g_live, 1);
+  // object and reference count in one block
+  BOOST_CHECK_EQUAL(slab->numBlocksInUse(), 1);
+
+  void* block = obj.get();
+  obj.reset();
+  BOOST_CHECK_EQUAL(g_live, 0);
+  BOOST_CHECK_EQUAL(slab->numBlocksInUse(), 0);
+
+  obj = boost::allocate_shared<Object>(LoopAllocator<Object>(slab), 3, 4);
+  BOOST_CHECK(obj.get() == block);
+
+  // the object outlives whoever created the slab
+  slab.reset();
+  BOOST_CHECK(!weakSlab.expired());
+  obj.reset();
+  BOOST_CHECK(weakSlab.expired());
+}
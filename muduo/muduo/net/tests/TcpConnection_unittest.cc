@@ -0,0 +1,317 @@
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/TcpServer.h>
+
+#include <boost/bind.hpp>
+
+#include <set>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE TcpConnectionTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::Timestamp;
+using muduo::net::Buffer;
+using muduo::net::EventLoop;
+using muduo::net::InetAddress;
+using muduo::net::TcpClient;
+using muduo::net::TcpConnectionPtr;
+using muduo::net::TcpServer;
+
+namespace
+{
+
+const size_t kLargeMessage = 8*1024*1024;
+
+// client side, counts what arrives, quits when done or closed
+struct Receiver
+{
+  Receiver(EventLoop* loop, size_t expected)
+    : loop_(loop), expected_(expected), received_(0), closed_(false)
+  { }
+
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (!conn->connected())
+    {
+      closed_ = true;
+      loop_->quit();
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+  {
+    received_ += buf->readableBytes();
+    buf->retrieveAll();
+    if (received_ >= expected_)
+    {
+      loop_->quit();
+    }
+  }
+
+  EventLoop* loop_;
+  size_t expected_;
+  size_t received_;
+  bool closed_;
+};
+
+struct NameCollector
+{
+  NameCollector(EventLoop* loop, size_t expected)
+    : loop_(loop), expected_(expected)
+  { }
+
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      names_.insert(conn->name());
+      if (names_.size() == expected_)
+      {
+        loop_->quit();
+      }
+    }
+  }
+
+  EventLoop* loop_;
+  size_t expected_;
+  std::set<string> names_;
+};
+
+void sendAfterStopRead(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->stopRead();
+    conn->send(string(kLargeMessage, 'x'));
+  }
+}
+
+// server side of testEdgeTriggeredStopReadWithPendingOutput
+struct StoppedReader
+{
+  StoppedReader(EventLoop* loop)
+    : loop_(loop), messages_(0), messagesWhileStopped_(-1)
+  { }
+
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      // the peer doesn't read either, the output stays pending
+      conn_ = conn;
+      conn->stopRead();
+      conn->send(string(kLargeMessage, 'x'));
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+  {
+    ++messages_;
+    buf->retrieveAll();
+    loop_->quit();
+  }
+
+  void resume()
+  {
+    messagesWhileStopped_ = messages_;
+    if (conn_)
+    {
+      conn_->startRead();
+    }
+  }
+
+  EventLoop* loop_;
+  TcpConnectionPtr conn_;
+  int messages_;
+  int messagesWhileStopped_;
+};
+
+void sendAndShutdown(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->stopRead();
+    conn->send("hello");
+    conn->shutdown();
+  }
+}
+
+int g_fileFd = -1;
+
+void sendPastEndOfFile(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    // the file has 100 bytes
+    conn->sendFile(g_fileFd, 1000, 10);
+  }
+}
+
+void sendPastEndOfFileOnMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  buf->retrieveAll();
+  sendPastEndOfFile(conn);
+}
+
+void sendHello(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->send("hello");
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(testEdgeTriggeredSendAfterStopRead)
+{
+  EventLoop loop;
+  if (!loop.supportsEdgeTriggered())
+  {
+    return;
+  }
+  InetAddress listenAddr("127.0.0.1", 20160);
+  TcpServer server(&loop, listenAddr, "ServerET");
+  server.setEdgeTriggered(true);
+  server.setConnectionCallback(sendAfterStopRead);
+  server.start();
+
+  // the channel has no events after stopRead(), writing must register it again
+  Receiver receiver(&loop, kLargeMessage);
+  TcpClient client(&loop, listenAddr, "ClientET");
+  client.setConnectionCallback(boost::bind(&Receiver::onConnection, &receiver, _1));
+  client.setMessageCallback(boost::bind(&Receiver::onMessage, &receiver, _1, _2, _3));
+  client.connect();
+  loop.runAfter(10.0, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+
+  BOOST_CHECK_EQUAL(receiver.received_, kLargeMessage);
+}
+
+BOOST_AUTO_TEST_CASE(testEdgeTriggeredStopReadWithPendingOutput)
+{
+  EventLoop loop;
+  if (!loop.supportsEdgeTriggered())
+  {
+    return;
+  }
+  InetAddress listenAddr("127.0.0.1", 20162);
+  TcpServer server(&loop, listenAddr, "ServerETStopped");
+  server.setEdgeTriggered(true);
+  StoppedReader reader(&loop);
+  server.setConnectionCallback(boost::bind(&StoppedReader::onConnection, &reader, _1));
+  server.setMessageCallback(boost::bind(&StoppedReader::onMessage, &reader, _1, _2, _3));
+  server.start();
+
+  // data and FIN arrive while the server is writing with reading stopped
+  TcpClient client(&loop, listenAddr, "ClientETStopped");
+  client.setConnectionCallback(sendAndShutdown);
+  client.connect();
+  loop.runAfter(0.5, boost::bind(&StoppedReader::resume, &reader));
+  loop.runAfter(10.0, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+
+  BOOST_CHECK_EQUAL(reader.messagesWhileStopped_, 0);
+  BOOST_CHECK_EQUAL(reader.messages_, 1);
+}
+
+BOOST_AUTO_TEST_CASE(testUnixDomainConnectionNames)
+{
+  // longer than the 32-byte buffer names were once built in
+  const char* path = "/tmp/muduo_tcpconnection_unittest_with_a_long_name.sock";
+  InetAddress listenAddr(InetAddress::unixDomain(path));
+
+  // left by a crashed run, nobody listens on it
+  int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ::unlink(path);
+  BOOST_REQUIRE_EQUAL(::bind(stale, listenAddr.getSockAddr(), listenAddr.getSockLen()), 0);
+  ::close(stale);
+
+  EventLoop loop;
+  NameCollector collector(&loop, 3);
+  TcpServer server(&loop, listenAddr, "ServerUnix", TcpServer::kReusePort);
+  server.setConnectionCallback(boost::bind(&NameCollector::onConnection, &collector, _1));
+  server.start();
+
+  TcpClient client1(&loop, listenAddr, "Client1");
+  TcpClient client2(&loop, listenAddr, "Client2");
+  TcpClient client3(&loop, listenAddr, "Client3");
+  client1.connect();
+  client2.connect();
+  client3.connect();
+  loop.runAfter(10.0, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+
+  BOOST_CHECK_EQUAL(collector.names_.size(), 3);
+  BOOST_CHECK(collector.names_.count(string("ServerUnix:") + path + "#3"));
+}
+
+int createFileOf100Bytes()
+{
+  char filename[] = "/tmp/muduo_tcpconnection_unittest.XXXXXX";
+  int fd = ::mkstemp(filename);
+  BOOST_REQUIRE(fd >= 0);
+  ::unlink(filename);
+  BOOST_REQUIRE_EQUAL(::write(fd, string(100, 'x').data(), 100), 100);
+  return fd;
+}
+
+BOOST_AUTO_TEST_CASE(testSendFilePastEndOfFile)
+{
+  g_fileFd = createFileOf100Bytes();
+
+  EventLoop loop;
+  InetAddress listenAddr("127.0.0.1", 20161);
+  TcpServer server(&loop, listenAddr, "ServerSendFile");
+  server.setConnectionCallback(sendPastEndOfFile);
+  server.start();
+
+  // the connection is closed, not left waiting for bytes never sent
+  Receiver receiver(&loop, 10);
+  TcpClient client(&loop, listenAddr, "ClientSendFile");
+  client.setConnectionCallback(boost::bind(&Receiver::onConnection, &receiver, _1));
+  client.setMessageCallback(boost::bind(&Receiver::onMessage, &receiver, _1, _2, _3));
+  client.connect();
+  loop.runAfter(10.0, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  ::close(g_fileFd);
+
+  BOOST_CHECK(receiver.closed_);
+  BOOST_CHECK_EQUAL(receiver.received_, 0);
+}
+
+BOOST_AUTO_TEST_CASE(testSendFilePastEndOfFileInMessageCallback)
+{
+  g_fileFd = createFileOf100Bytes();
+
+  EventLoop loop;
+  InetAddress listenAddr("127.0.0.1", 20163);
+  TcpServer server(&loop, listenAddr, "ServerSendFileET");
+  // ET reads on after MessageCallback, it must not after the close
+  server.setEdgeTriggered(true);
+  server.setMessageCallback(sendPastEndOfFileOnMessage);
+  server.start();
+
+  Receiver receiver(&loop, 10);
+  TcpClient client(&loop, listenAddr, "ClientSendFileET");
+  client.setConnectionCallback(boost::bind(&Receiver::onConnection, &receiver, _1));
+  client.setMessageCallback(boost::bind(&Receiver::onMessage, &receiver, _1, _2, _3));
+  client.connect();
+  loop.runAfter(0.1, boost::bind(sendHello, boost::bind(&TcpClient::connection, &client)));
+  loop.runAfter(10.0, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  ::close(g_fileFd);
+
+  BOOST_CHECK(receiver.closed_);
+  BOOST_CHECK_EQUAL(receiver.received_, 0);
+}
@@ -0,0 +1,110 @@
+// Churns timers like idle timeouts do, compares TimerList backends.
+//
+// Usage: timerqueue_bench [set|wheel] [timers=1000000] [rearms=5000000] [slack_ms=0]
+//
+// Adds timers expiring in 1~60 seconds, then repeatedly cancels a random
+// one and adds it again.  At last, adds timers expiring in the next second
+// and measures how late they fire, and how many wakeups it takes.
+
+#include <muduo/net/EventLoop.h>
+#include <muduo/base/Timestamp.h>
+
+#include <boost/bind.hpp>
+
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+EventLoop* g_loop;
+int g_fired = 0;
+int g_expected = 0;
+int64_t g_totalLate = 0;
+int64_t g_maxLate = 0;
+
+void idle()
+{
+}
+
+void fired(Timestamp when)
+{
+  int64_t late = Timestamp::now().microSecondsSinceEpoch() - when.microSecondsSinceEpoch();
+  if (late < 0)
+  {
+    printf("fired %lld us early\n", static_cast<long long>(-late));
+    abort();
+  }
+  g_totalLate += late;
+  g_maxLate = std::max(g_maxLate, late);
+  if (++g_fired == g_expected)
+  {
+    g_loop->quit();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const bool wheel = argc > 1 && strcmp(argv[1], "wheel") == 0;
+  const int numTimers = argc > 2 ? atoi(argv[2]) : 1000000;
+  const int numRearms = argc > 3 ? atoi(argv[3]) : 5000000;
+  const double slackMs = argc > 4 ? atof(argv[4]) : 0.0;
+  if (wheel)
+  {
+    ::setenv("MUDUO_USE_TIMER_WHEEL", "1", 1);
+  }
+
+  EventLoop loop;
+  g_loop = &loop;
+  loop.setTimerSlack(slackMs / 1000.0);
+  srand(42);
+
+  std::vector<TimerId> timers;
+  timers.reserve(numTimers);
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < numTimers; ++i)
+  {
+    timers.push_back(loop.runAfter(1.0 + rand() % 60000 / 1000.0, idle));
+  }
+  Timestamp added(Timestamp::now());
+
+  for (int i = 0; i < numRearms; ++i)
+  {
+    int idx = rand() % numTimers;
+    loop.cancel(timers[idx]);
+    timers[idx] = loop.runAfter(1.0 + rand() % 60000 / 1000.0, idle);
+  }
+  Timestamp rearmed(Timestamp::now());
+
+  printf("%s: add %d timers %.3f seconds, %.0f adds/s\n",
+         wheel ? "wheel" : "set", numTimers, timeDifference(added, start),
+         numTimers / timeDifference(added, start));
+  printf("%s: cancel and add %d times %.3f seconds, %.0f rearms/s\n",
+         wheel ? "wheel" : "set", numRearms, timeDifference(rearmed, added),
+         numRearms / timeDifference(rearmed, added));
+
+  for (size_t i = 0; i < timers.size(); ++i)
+  {
+    loop.cancel(timers[i]);
+  }
+
+  g_expected = 100000;
+  const int64_t timerUpdates = loop.syscallStats().timerUpdates;
+  Timestamp now(Timestamp::now());
+  for (int i = 0; i < g_expected; ++i)
+  {
+    Timestamp when(addTime(now, 0.1 + rand() % 1000000 / 1e6));
+    loop.runAt(when, boost::bind(fired, when));
+  }
+  loop.loop();
+  printf("%s: fired %d timers, average %lld us late, max %lld us late\n",
+         wheel ? "wheel" : "set", g_fired,
+         static_cast<long long>(g_totalLate / g_fired),
+         static_cast<long long>(g_maxLate));
+  printf("%s: slack %g ms, %lld poll, %lld timerfd_settime\n",
+         wheel ? "wheel" : "set", slackMs,
+         static_cast<long long>(loop.iteration()),
+         static_cast<long long>(loop.syscallStats().timerUpdates - timerUpdates));
+}
@@ -0,0 +1,27 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/TimerList.h>
+#include <muduo/net/timer/SetTimerList.h>
+#include <muduo/net/timer/WheelTimerList.h>
+
+#include <stdlib.h>
+
+using namespace muduo::net;
+
+TimerList* TimerList::newDefaultTimerList()
+{
+  if (::getenv("MUDUO_USE_TIMER_WHEEL"))
+  {
+    return new WheelTimerList;
+  }
+  else
+  {
+    return new SetTimerList;
+  }
+}
@@ -0,0 +1,69 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#define __STDC_LIMIT_MACROS
+#include <muduo/net/timer/SetTimerList.h>
+
+#include <muduo/net/Timer.h>
+
+#include <assert.h>
+#include <stdint.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+SetTimerList::SetTimerList()
+{
+}
+
+SetTimerList::~SetTimerList()
+{
+  for (TimerSet::iterator it = timers_.begin();
+      it != timers_.end(); ++it)
+  {
+    delete it->second;
+  }
+}
+
+bool SetTimerList::insert(Timer* timer)
+{
+  bool earliestChanged = false;
+  Timestamp when = timer->expiration();
+  TimerSet::iterator it = timers_.begin();
+  if (it == timers_.end() || when < it->first)
+  {
+    earliestChanged = true;
+  }
+  std::pair<TimerSet::iterator, bool> result
+    = timers_.insert(Entry(when, timer));
+  assert(result.second); (void)result;
+  return earliestChanged;
+}
+
+void SetTimerList::erase(Timer* timer)
+{
+  size_t n = timers_.erase(Entry(timer->expiration(), timer));
+  assert(n == 1); (void)n;
+}
+
+void SetTimerList::getExpired(Timestamp now, std::vector<Timer*>* expired)
+{
+  Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
+  TimerSet::iterator end = timers_.lower_bound(sentry);
+  assert(end == timers_.end() || now < end->first);
+  for (TimerSet::iterator it = timers_.begin(); it != end; ++it)
+  {
+    expired->push_back(it->second);
+  }
+  timers_.erase(timers_.begin(), end);
+}
+
+Timestamp SetTimerList::nextExpiration() const
+{
+  return timers_.empty() ? Timestamp::invalid() : timers_.begin()->first;
+}
@@ -0,0 +1,48 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMER_SETTIMERLIST_H
+#define MUDUO_NET_TIMER_SETTIMERLIST_H
+
+#include <muduo/net/TimerList.h>
+
+#include <set>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Timers sorted by expiration in std::set, O(log n) insert and erase.
+///
+class SetTimerList : public TimerList
+{
+ public:
+  SetTimerList();
+  virtual ~SetTimerList();
+
+  virtual bool insert(Timer* timer);
+  virtual void erase(Timer* timer);
+  virtual void getExpired(Timestamp now, std::vector<Timer*>* expired);
+  virtual Timestamp nextExpiration() const;
+  virtual size_t size() const { return timers_.size(); }
+
+ private:
+  // FIXME: use unique_ptr<Timer> instead of raw pointers.
+  typedef std::pair<Timestamp, Timer*> Entry;
+  typedef std::set<Entry> TimerSet;
+
+  TimerSet timers_;
+};
+
+}
+}
+#endif  // MUDUO_NET_TIMER_SETTIMERLIST_H
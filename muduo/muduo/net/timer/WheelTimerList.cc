@@ -0,0 +1,225 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#define __STDC_LIMIT_MACROS
+#include <muduo/net/timer/WheelTimerList.h>
+
+#include <muduo/net/Timer.h>
+
+#include <assert.h>
+#include <strings.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int WheelTimerList::kTickMicroSeconds;
+const int WheelTimerList::kSlotBits;
+const int WheelTimerList::kSlots;
+const int WheelTimerList::kLevels;
+
+namespace
+{
+const int64_t kSlotMask = WheelTimerList::kSlots - 1;
+
+int64_t levelSpan(int level)
+{
+  return static_cast<int64_t>(1) << (WheelTimerList::kSlotBits * level);
+}
+
+// distance from bit @c start to next set bit, wrapping around
+int nextSetBit(uint64_t bits, int start)
+{
+  assert(bits != 0);
+  uint64_t rotated = start == 0 ? bits : (bits >> start) | (bits << (64 - start));
+  return __builtin_ctzll(rotated);
+}
+}
+
+WheelTimerList::WheelTimerList()
+  : nextTick_(Timestamp::now().microSecondsSinceEpoch() / kTickMicroSeconds),
+    size_(0)
+{
+  bzero(occupied_, sizeof occupied_);
+  bzero(slots_, sizeof slots_);
+}
+
+WheelTimerList::~WheelTimerList()
+{
+  for (int slot = 0; slot < kLevels * kSlots; ++slot)
+  {
+    Timer* timer = slots_[slot];
+    while (timer)
+    {
+      Timer* next = timer->next_;
+      delete timer;
+      timer = next;
+    }
+  }
+}
+
+int64_t WheelTimerList::toTick(Timestamp when)
+{
+  // round up, never expire early
+  return (when.microSecondsSinceEpoch() + kTickMicroSeconds - 1) / kTickMicroSeconds;
+}
+
+bool WheelTimerList::insert(Timer* timer)
+{
+  int64_t before = nextEventTick();
+  place(timer);
+  ++size_;
+  return nextEventTick() < before;
+}
+
+void WheelTimerList::erase(Timer* timer)
+{
+  const int slot = timer->slot_;
+  assert(slot >= 0);
+  if (timer->prev_)
+  {
+    timer->prev_->next_ = timer->next_;
+  }
+  else
+  {
+    assert(slots_[slot] == timer);
+    slots_[slot] = timer->next_;
+  }
+  if (timer->next_)
+  {
+    timer->next_->prev_ = timer->prev_;
+  }
+  if (slots_[slot] == NULL)
+  {
+    occupied_[slot / kSlots] &= ~(static_cast<uint64_t>(1) << (slot % kSlots));
+  }
+  timer->prev_ = NULL;
+  timer->next_ = NULL;
+  timer->slot_ = -1;
+  --size_;
+}
+
+void WheelTimerList::getExpired(Timestamp now, std::vector<Timer*>* expired)
+{
+  const int64_t nowTick = now.microSecondsSinceEpoch() / kTickMicroSeconds;
+  int64_t tick = 0;
+  while ((tick = nextEventTick()) <= nowTick)
+  {
+    // empty ticks are skipped, so are cascades of empty slots
+    nextTick_ = tick;
+    for (int level = 1; level < kLevels && (tick & (levelSpan(level) - 1)) == 0; ++level)
+    {
+      cascade(level);
+    }
+
+    Timer* timer = detach(static_cast<int>(tick & kSlotMask));
+    while (timer)
+    {
+      Timer* next = timer->next_;
+      timer->prev_ = NULL;
+      timer->next_ = NULL;
+      timer->slot_ = -1;
+      expired->push_back(timer);
+      --size_;
+      timer = next;
+    }
+    nextTick_ = tick + 1;
+  }
+
+  if (nextTick_ <= nowTick)
+  {
+    nextTick_ = nowTick + 1;
+  }
+}
+
+Timestamp WheelTimerList::nextExpiration() const
+{
+  int64_t tick = nextEventTick();
+  return tick == INT64_MAX ? Timestamp::invalid()
+                           : Timestamp(tick * kTickMicroSeconds);
+}
+
+void WheelTimerList::place(Timer* timer)
+{
+  int64_t tick = toTick(timer->expiration());
+  if (tick < nextTick_)
+  {
+    tick = nextTick_;
+  }
+
+  int level = 0;
+  while (level < kLevels - 1 && tick - nextTick_ >= levelSpan(level + 1))
+  {
+    ++level;
+  }
+  if (tick - nextTick_ >= levelSpan(kLevels))
+  {
+    // too far away, cascades again when it comes down
+    tick = nextTick_ + levelSpan(kLevels) - 1;
+  }
+  int index = static_cast<int>((tick >> (kSlotBits * level)) & kSlotMask);
+  link(timer, level * kSlots + index);
+}
+
+void WheelTimerList::link(Timer* timer, int slot)
+{
+  timer->prev_ = NULL;
+  timer->next_ = slots_[slot];
+  if (timer->next_)
+  {
+    timer->next_->prev_ = timer;
+  }
+  slots_[slot] = timer;
+  timer->slot_ = slot;
+  occupied_[slot / kSlots] |= static_cast<uint64_t>(1) << (slot % kSlots);
+}
+
+Timer* WheelTimerList::detach(int slot)
+{
+  Timer* head = slots_[slot];
+  slots_[slot] = NULL;
+  occupied_[slot / kSlots] &= ~(static_cast<uint64_t>(1) << (slot % kSlots));
+  return head;
+}
+
+void WheelTimerList::cascade(int level)
+{
+  int index = static_cast<int>((nextTick_ >> (kSlotBits * level)) & kSlotMask);
+  Timer* timer = detach(level * kSlots + index);
+  while (timer)
+  {
+    Timer* next = timer->next_;
+    place(timer);
+    timer = next;
+  }
+}
+
+int64_t WheelTimerList::nextEventTick() const
+{
+  int64_t result = INT64_MAX;
+  if (occupied_[0])
+  {
+    result = nextTick_ + nextSetBit(occupied_[0], static_cast<int>(nextTick_ & kSlotMask));
+  }
+  for (int level = 1; level < kLevels; ++level)
+  {
+    if (occupied_[level])
+    {
+      // slot i of this level cascades at the tick which is a multiple
+      // of levelSpan(level), with index i at this level
+      const int64_t span = levelSpan(level);
+      int64_t boundary = (nextTick_ + span - 1) & ~(span - 1);
+      int index = static_cast<int>((boundary >> (kSlotBits * level)) & kSlotMask);
+      int64_t tick = boundary + nextSetBit(occupied_[level], index) * span;
+      if (tick < result)
+      {
+        result = tick;
+      }
+    }
+  }
+  return result;
+}
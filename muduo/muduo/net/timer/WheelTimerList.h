@@ -0,0 +1,65 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMER_WHEELTIMERLIST_H
+#define MUDUO_NET_TIMER_WHEELTIMERLIST_H
+
+#include <muduo/net/TimerList.h>
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Hierarchical timing wheel, O(1) insert and erase.
+///
+/// Level 0 has one slot per millisecond tick, each upper level covers
+/// 64 times the span of the level below.  Timers are cascaded down
+/// when the lower level wraps around, and never expire early.
+/// Timers in the same tick expire together, in no particular order.
+class WheelTimerList : public TimerList
+{
+ public:
+  static const int kTickMicroSeconds = 1000;
+  static const int kSlotBits = 6;
+  static const int kSlots = 1 << kSlotBits;
+  static const int kLevels = 6;  // 2^36 ticks, about 795 days
+
+  WheelTimerList();
+  virtual ~WheelTimerList();
+
+  virtual bool insert(Timer* timer);
+  virtual void erase(Timer* timer);
+  virtual void getExpired(Timestamp now, std::vector<Timer*>* expired);
+  virtual Timestamp nextExpiration() const;
+  virtual size_t size() const { return size_; }
+
+ private:
+  static int64_t toTick(Timestamp when);
+
+  void place(Timer* timer);
+  void link(Timer* timer, int slot);
+  Timer* detach(int slot);
+  void cascade(int level);
+  // tick of next expiring or cascading, INT64_MAX if empty
+  int64_t nextEventTick() const;
+
+  int64_t nextTick_;  // ticks before it are done
+  size_t size_;
+  uint64_t occupied_[kLevels];  // bitmap of non-empty slots
+  Timer* slots_[kLevels * kSlots];
+};
+
+}
+}
+#endif  // MUDUO_NET_TIMER_WHEELTIMERLIST_H